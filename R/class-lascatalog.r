@@ -72,7 +72,10 @@
 #' @slot data data.table. A table representing the header of each file.
 #' @slot crs A \link[sp:CRS]{CRS} object.
 #' @slot cores integer. Numer of cores used to make parallel computations in compatible functions that
-#' support a \code{LAScatalog} as input. Default is 1.
+#' support a \code{LAScatalog} as input. Default is 1. With several cores each cluster is processed
+#' by a separate R process. With a single core the clusters are processed sequentially in the
+#' current R session without copying the data, and the functions that support the option
+#' \code{threads} of \link{lidr_options} run in parallel within each cluster.
 #' @slot buffer numeric. When applying a function to an entire catalog by sequentially processing
 #' sub-areas (clusters), some algorithms (such as \link{grid_terrain}) require a buffer around the area
 #' to avoid edge effects. Default is 15 units.
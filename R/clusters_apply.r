@@ -14,6 +14,10 @@ cluster_apply = function(clusters, f, ncores, progress, stop_early, ...)
   filter   <- if(is.null(dots$filter)) "" else dots$filter
   autoread <- if(is.null(dots$autoread)) FALSE else TRUE
 
+  # A single worker: no need for futures. The clusters are processed in this R session.
+  if (ncores == 1)
+    return(session_apply(clusters, f, progress, stop_early, autoread, select, filter, ...))
+
   future::plan(future::multiprocess, workers = ncores)
 
   required.pkgs <- "lidR"
@@ -40,9 +44,7 @@ cluster_apply = function(clusters, f, ncores, progress, stop_early, ...)
     }
   }
 
-  # Display the color legend over the LAScatalog that should have already been plotted.
-  if (progress)
-    graphics::legend("topright", title = "Colors", legend = c("No data","Ok","Errors (skipped)"), fill = c("gray","forestgreen", "red"), cex = 0.8)
+  if (progress) display_legend()
 
   # Parallel loop using promises
   for (i in seq_along(clusters))
@@ -98,6 +100,61 @@ cluster_apply = function(clusters, f, ncores, progress, stop_early, ...)
   return(output)
 }
 
+# Sequential processing of the clusters in the current R session. Unlike the futures there is
+# no worker process: the inputs and the outputs are not serialized, the memory is shared and the
+# native functions can use all the threads of the machine (see lidr_options(threads)) inside
+# each cluster.
+session_apply = function(clusters, f, progress, stop_early, autoread, select, filter, ...)
+{
+  nclust <- length(clusters)
+  output <- vector("list", nclust)
+  codes  <- rep(ASYNC_RUN, nclust)
+  dots   <- list(...)
+
+  instrumented <- C_instrumentation_enabled()
+
+  if (progress) display_legend()
+
+  for (i in seq_along(clusters))
+  {
+    if (instrumented) C_instrumentation_label(clusters[[i]]@name)
+
+    codes[i] = tryCatch(
+    {
+      if (autoread)
+      {
+        las = readLAS(clusters[[i]], select, filter)
+        x = if (is.null(las)) NULL else do.call(f, c(las, dots$func_args))
+      }
+      else
+      {
+        x = f(clusters[[i]], ...)
+      }
+
+      if (!is.null(x))
+      {
+        output[[i]] = x
+        ASYNC_OK
+      }
+      else
+        ASYNC_NULL
+    }, error = function(e) {
+      if (stop_early)
+        stop(e)
+      else
+        return(ASYNC_ERROR)
+    })
+
+    if (progress) display_progress(clusters[[i]]@bbox, i/nclust, codes[i])
+  }
+
+  if (instrumented) C_instrumentation_label("")
+  if (progress) cat("\n")
+
+  output = output[codes == ASYNC_OK]
+  return(output)
+}
+
 early_eval <- function(future, stop_early)
 {
   code = ASYNC_RUN
@@ -123,6 +180,12 @@ early_eval <- function(future, stop_early)
   return(code)
 }
 
+# Display the color legend over the LAScatalog that should have already been plotted.
+display_legend = function()
+{
+  graphics::legend("topright", title = "Colors", legend = c("No data","Ok","Errors (skipped)"), fill = c("gray","forestgreen", "red"), cex = 0.8)
+}
+
 display_progress = function(bbox, p, code)
 {
   cat(sprintf("\rProgress: %g%%", round(p*100)), file = stderr())
@@ -50,6 +50,11 @@
 #' When the parameter \code{x} is a \link[lidR:LAScatalog-class]{LAScatalog} the function processes
 #' the entire dataset in a continuous way using a multicore process. The user can modify the processing
 #' options using the \link[lidR:catalog]{available options}.\cr\cr
+#' On a single core, without \code{na.fill} and without virtual raster output, the points are
+#' streamed cluster by cluster into a single raster covering the whole catalog. Only the raster
+#' and the points of one cluster are loaded in memory at a time and no buffer is needed. If this
+#' raster, allocated on the bounding box of the catalog, does not fit in \code{memlimit} (see
+#' \link[lidR:lidr_options]{lidr_options}) the catalog is processed cluster by cluster with a buffer.\cr\cr
 #' \code{lidR} supports .lax files. Computation speed will be \emph{significantly} improved with a
 #' spatial index.
 #'
@@ -170,8 +175,24 @@ grid_canopy.LAScatalog = function(x, res = 2, subcircle = 0, na.fill = "none", .
 
   x = catalog_old_compatibility(x)
 
+  # Without interpolation the points can be streamed into a single raster if it fits in memory
+  if (na.fill == "none" && !save_vrt(x) && cores(x) == 1L && raster_stream_fits(x, res, "max", subcircle))
+    return(rasterize_catalog(x, res, c(Z = "max"), subcircle, filter))
+
   buffer(x) <- res/2 + subcircle
-  canopy = grid_catalog(x, grid_canopy, res, "xyz", filter, subcircle = subcircle, na.fill = na.fill, ...)
+  canopy = grid_catalog(x, grid_canopy_cluster, res, "xyz", filter, subcircle = subcircle, na.fill = na.fill, ...)
   return(canopy)
 }
 
+# grid_canopy applied by grid_catalog on a cluster of a catalog. Without interpolation only the
+# cells of the core of the cluster are computed (see apply_grid_func). The interpolation needs
+# the cells of the buffer.
+grid_canopy_cluster = function(x, res, subcircle, na.fill, core = NULL, ...)
+{
+  if (na.fill != "none")
+    return(grid_canopy(x, res, subcircle, na.fill, ...))
+
+  dsm = C_grid_canopy(x, res, subcircle, core)
+  as.lasmetrics(dsm, res)
+  return(dsm)
+}
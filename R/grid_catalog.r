@@ -187,6 +187,45 @@ grid_catalog <- function(catalog, grid_func, res, select = "*", filter = "", sta
   return(output)
 }
 
+# Streams the points of a catalog cluster by cluster into a single raster that covers the whole
+# catalog (see C_rasterize for 'stats'). Only the raster and the points of one cluster are in
+# memory at a time. The clusters have no buffer: the statistics are updated in place so a cell
+# shared by several clusters gets the points of each of them. The clusters are processed in the
+# current R session since the raster lives in the native memory of this session. The layers are
+# named after names(stats) if any e.g. c(Z = "max"), otherwise after the statistics.
+rasterize_catalog = function(catalog, res, stats, subcircle = 0, filter = "")
+{
+  layers <- names(stats)
+  if (is.null(layers)) layers <- stats
+  layers[layers == ""] <- stats[layers == ""]
+
+  bbox   <- with(catalog@data, c(min(`Min X`), min(`Min Y`), max(`Max X`), max(`Max Y`)))
+  stream <- C_raster_stream_create(bbox[1] - subcircle, bbox[2] - subcircle, bbox[3] + subcircle, bbox[4] + subcircle, res, unname(stats), layers)
+  select <- if (any(grepl("_first$", stats))) "xyzr" else "xyz"
+
+  buffer(catalog) <- 0
+  clusters <- catalog_makecluster(catalog, res)
+
+  update = function(cluster)
+  {
+    las <- readLAS(cluster, select = select, filter = filter)
+
+    if (is.null(las))
+      return(NULL)
+
+    rn <- if (select == "xyzr") las@data$ReturnNumber else integer(0)
+    C_raster_stream_update(stream, las@data$X, las@data$Y, las@data$Z, rn, subcircle)
+    return(TRUE)
+  }
+
+  cluster_apply(clusters, update, 1L, progress(catalog), stop_early(catalog))
+
+  ret <- C_raster_stream_values(stream)
+  data.table::setDT(ret)
+  as.lasmetrics(ret, res)
+  return(ret)
+}
+
 # Apply a grid_* function for a given ROI of a catlog
 #
 # @param X list. the coordinates of the region of interest (rectangular)
@@ -215,6 +254,10 @@ apply_grid_func = function(cluster, grid_func, param, filter, select)
   if (is.null(las))
     return(NULL)
 
+  # The grid functions that support it only compute the cells of the core of the cluster
+  if ("core" %in% names(formals(grid_func)))
+    param$core <- c(xleft+0.5*res, ybottom+0.5*res, xright-0.5*res, ytop-0.5*res)
+
   # Call the function
   param$x   <- las
   metrics   <- do.call(grid_func, args = param)
@@ -242,6 +285,21 @@ apply_grid_func = function(cluster, grid_func, param, filter, select)
   }
 }
 
+# rasterize_catalog() allocates a dense raster on the bounding box of the whole catalog. This
+# can be much larger than the tiles themselves for a sparse catalog (e.g. a corridor), so the
+# stream is used only if this raster fits in memlimit. Each cell holds one double per
+# statistic and one or two integer counters.
+raster_stream_fits = function(catalog, res, stats, subcircle = 0)
+{
+  bbox    <- with(catalog@data, c(min(`Min X`), min(`Min Y`), max(`Max X`), max(`Max Y`)))
+  ncols   <- ceiling((bbox[3] - bbox[1] + 2*subcircle) / res) + 3
+  nrows   <- ceiling((bbox[4] - bbox[2] + 2*subcircle) / res) + 3
+  ncount  <- if (any(grepl("_first$", stats))) 2 else 1
+  nbytes  <- ncols * nrows * (8 * length(stats) + 4 * ncount)
+
+  return(nbytes <= LIDROPTIONS("memlimit"))
+}
+
 memory_test = function(catalog, resolution)
 {
   surface <- area(catalog)
@@ -73,7 +73,7 @@ grid_density.LAS = function(x, res = 4, filter = "")
 
   if(! "pulseID" %in% names(x@data))
   {
-    ret = grid_metrics(x, list(point_density = length(X)/res^2), res)
+    ret = grid_density_cluster(x, res)
   }
   else
   {
@@ -89,6 +89,21 @@ grid_density.LAScatalog = function(x, res = 4, filter = "")
   x = catalog_old_compatibility(x)
 
   buffer(x) <- res/2
-  ret <- grid_catalog(x, grid_density, res, "xyzt", filter)
+  ret <- grid_catalog(x, grid_density_cluster, res, "xyzt", filter)
+  return(ret)
+}
+
+# grid_density applied by grid_catalog on a cluster of a catalog. Without pulseID the points are
+# counted in a single pass by the rasterization engine of grid_stats and only the cells of the
+# core of the cluster are computed (see apply_grid_func).
+grid_density_cluster = function(x, res, core = NULL)
+{
+  point_density <- NULL
+
+  if ("pulseID" %in% names(x@data))
+    return(grid_density(x, res))
+
+  ret = rasterize_stats(x, res, c(point_density = "count"), 0, core)
+  ret[, point_density := point_density/res^2]
   return(ret)
 }
@@ -57,6 +57,12 @@
 #' dispatch the LiDAR data for each cell in the user's function. The user writes their
 #' function without considering grid cells, only a point cloud (see example).
 #'
+#' When \code{func} is a list made only of simple metrics on numeric attributes such as
+#' \code{max(Z)}, \code{min(Z)}, \code{mean(Z)}, \code{sd(Z)}, \code{var(Z)}, \code{sum(Z)},
+#' \code{quantile(Z, 0.95)}, \code{sum(Z > 2)/length(Z)*100}, \code{sum(ReturnNumber == 1)},
+#' \code{length(Z)} or \code{.N}, the metrics are computed natively without evaluating an R
+#' expression in each cell, which is much faster. Any other expression is evaluated in R.
+#'
 #' @section Parameter \code{start}:
 #' The algorithm will always provide the same coordinates independently of the dataset.
 #' When start = (0,0) and res = 20 grid_metrics will produce the following raster centers:
@@ -128,6 +134,15 @@ grid_metrics.LAS = function(x, func, res = 20, start = c(0,0), splitlines = FALS
   assertive::assert_is_logical(splitlines)
 
   call <- substitute(func)
+
+  if (!splitlines && !LIDROPTIONS("debug"))
+  {
+    stat <- fast_grid_metrics(x, call, res, start)
+
+    if (!is.null(stat))
+      return(stat)
+  }
+
   stat <- lasaggregate(x, by = "XY", call, res, start, c("X", "Y"), splitlines)
   return(stat)
 }
@@ -141,6 +156,192 @@ grid_metrics.LAScatalog = function(x, func, res = 20, start = c(0,0), splitlines
   buffer(x) <- 0
 
   call <- substitute(func)
-  stat <- grid_catalog(x, grid_metrics, res, "*+", filter, start, func = call)
+  stat <- grid_catalog(x, grid_metrics_cluster, res, "*+", filter, start, func = call)
+  return(stat)
+}
+
+# grid_metrics applied by grid_catalog on a cluster of a catalog. The native path only computes
+# the cells of the core of the cluster (see apply_grid_func)
+grid_metrics_cluster = function(x, func, res, start = c(0,0), core = NULL)
+{
+  call <- substitute(func)
+
+  if (!LIDROPTIONS("debug"))
+  {
+    stat <- fast_grid_metrics(x, call, res, start, core)
+
+    if (!is.null(stat))
+      return(stat)
+  }
+
+  stat <- lasaggregate(x, by = "XY", call, res, start, c("X", "Y"), FALSE)
   return(stat)
 }
+
+# Fast path of grid_metrics and grid_metrics3d. If the call is made only of built-in metrics such as
+# list(zmax = max(Z), zq95 = quantile(Z, 0.95), pzabove2 = sum(Z > 2)/length(Z)*100, n1 = sum(ReturnNumber == 1))
+# the metrics are computed in C++ without evaluating an R expression per cell. A 'start' of
+# length 3 means voxels. Returns NULL if the call is not supported and must be evaluated with
+# lasaggregate. If core = c(xmin, ymin, xmax, ymax) is given only the cells whose center is in
+# this rectangle are computed (2D only).
+fast_grid_metrics = function(las, call, res, start, core = NULL)
+{
+  if (!is.numeric(res) || length(res) != 1 || res <= 0 || !is.numeric(start) || !length(start) %in% c(2,3))
+    return(NULL)
+
+  spec = fast_metrics_call(call, las@data)
+
+  if (is.null(spec))
+    return(NULL)
+
+  vars = unique(spec$variable[!is.na(spec$variable)])
+  values = lapply(vars, function(v) as.numeric(las@data[[v]]))
+  variable = match(spec$variable, vars) - 1L
+  variable[is.na(variable)] = 0L
+
+  if (length(values) == 0)
+    values = list(las@data$X)
+
+  if (length(start) == 2)
+  {
+    stat = C_grid_metrics(las@data$X, las@data$Y, values, spec$metric, variable, spec$param, spec$name, res, start, LIDROPTIONS("threads"), core)
+    ._class = "lasmetrics"
+  }
+  else
+  {
+    stat = C_voxel_metrics(las@data$X, las@data$Y, las@data$Z, values, spec$metric, variable, spec$param, spec$name, res, start, LIDROPTIONS("threads"))
+    ._class = "lasmetrics3d"
+  }
+
+  data.table::setDT(stat)
+  data.table::setattr(stat, "class", c(._class, attr(stat, "class")))
+  data.table::setattr(stat, "res", res)
+  return(stat)
+}
+
+# Parses a call of grid_metrics into a list of built-in metrics (codes of C_grid_metrics).
+# Returns NULL if any part of the call is not a built-in metric.
+fast_metrics_call = function(call, data)
+{
+  # grid_catalog passes the call as an expression (see grid_catalog)
+  if (is.expression(call) && length(call) == 1)
+    call = call[[1]]
+
+  if (is.call(call) && identical(call[[1]], quote(list)))
+  {
+    args = as.list(call)[-1]
+    names = names(args)
+
+    if (length(args) == 0 || is.null(names) || any(names == "") || anyDuplicated(names))
+      return(NULL)
+  }
+  else
+  {
+    args = list(call)
+    names = "V1"
+  }
+
+  metric = integer(length(args))
+  variable = character(length(args))
+  param = numeric(length(args))
+
+  for (i in seq_along(args))
+  {
+    m = fast_metric(args[[i]], data)
+
+    if (is.null(m))
+      return(NULL)
+
+    metric[i] = m$metric
+    variable[i] = m$variable
+    param[i] = m$param
+  }
+
+  return(list(metric = metric, variable = variable, param = param, name = names))
+}
+
+fast_metric = function(e, data)
+{
+  # Numeric attribute without NA
+  is_attribute = function(x, double = TRUE)
+  {
+    if (!is.name(x)) return(FALSE)
+    x = as.character(x)
+    if (!x %in% names(data)) return(FALSE)
+    v = data[[x]]
+    if (double && !is.double(v)) return(FALSE)
+    if (!is.numeric(v)) return(FALSE)
+    return(!anyNA(v))
+  }
+
+  # Number of points: .N or length(<attribute>)
+  is_count = function(x)
+  {
+    if (identical(x, quote(.N))) return(TRUE)
+    is.call(x) && fname(x) == "length" && length(x) == 2 && is.name(x[[2]]) && as.character(x[[2]]) %in% names(data)
+  }
+
+  is_number = function(x) { is.numeric(x) && length(x) == 1 && !is.na(x) }
+  fname = function(x) { sub("^(base|stats)::", "", paste(deparse(x[[1]]), collapse = "")) }
+  metric = function(code, variable = NA_character_, param = 0) { list(metric = code, variable = variable, param = param) }
+
+  if (is_count(e))
+    return(metric(6L))
+
+  if (!is.call(e))
+    return(NULL)
+
+  f = fname(e)
+  simple = c(max = 0L, min = 1L, sum = 2L, mean = 3L, sd = 4L, var = 5L)
+
+  # max(Z), min(Z), sum(Z), mean(Z), sd(Z), var(Z)
+  if (f %in% names(simple) && length(e) == 2 && is.null(names(e)) && is_attribute(e[[2]]))
+    return(metric(simple[[f]], as.character(e[[2]])))
+
+  # quantile(Z, 0.95)
+  if (f == "quantile" && length(e) == 3 && is_attribute(e[[2]]))
+  {
+    n = names(e)
+    p = e[[3]]
+
+    if (!is.null(n) && !n[3] %in% c("", "probs"))
+      return(NULL)
+
+    if (is_number(p) && p >= 0 && p <= 1)
+      return(metric(7L, as.character(e[[2]]), p))
+
+    return(NULL)
+  }
+
+  # sum(ReturnNumber == 1)
+  if (f == "sum" && length(e) == 2 && is.call(e[[2]]) && identical(e[[2]][[1]], quote(`==`)))
+  {
+    cmp = e[[2]]
+
+    if (is_attribute(cmp[[2]], FALSE) && is_number(cmp[[3]]))
+      return(metric(9L, as.character(cmp[[2]]), cmp[[3]]))
+
+    return(NULL)
+  }
+
+  # sum(Z > 2)/length(Z)*100
+  if (identical(e[[1]], quote(`*`)) && length(e) == 3 && identical(e[[3]], 100))
+  {
+    ratio = e[[2]]
+
+    if (is.call(ratio) && identical(ratio[[1]], quote(`/`)) && is_count(ratio[[3]]))
+    {
+      s = ratio[[2]]
+
+      if (is.call(s) && fname(s) == "sum" && length(s) == 2 && is.call(s[[2]]) && identical(s[[2]][[1]], quote(`>`)))
+      {
+        cmp = s[[2]]
+
+        if (is_attribute(cmp[[2]]) && is_number(cmp[[3]]))
+          return(metric(8L, as.character(cmp[[2]]), cmp[[3]]))
+      }
+    }
+  }
+
+  return(NULL)
+}
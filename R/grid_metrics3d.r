@@ -87,6 +87,15 @@ grid_metrics3d = function(.las, func, res = 1, debug = FALSE)
   assertive::assert_all_are_non_negative(res)
 
   call <- substitute(func)
+
+  if (!debug && !LIDROPTIONS("debug"))
+  {
+    stat <- fast_grid_metrics(.las, call, res, c(0,0,0))
+
+    if (!is.null(stat))
+      return(stat)
+  }
+
   stat <- lasaggregate(.las, by = "XYZ", call, res, c(0,0,0), c("X", "Y", "Z"), FALSE, debug)
   return(stat)
 }
@@ -0,0 +1,86 @@
+# ===============================================================================
+#
+# PROGRAMMERS:
+#
+# jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+#
+# COPYRIGHT:
+#
+# Copyright 2018 Jean-Romain Roussel
+#
+# This file is part of lidR R package.
+#
+# lidR is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+# ===============================================================================
+
+
+
+#' Several statistics of the points per cell in a single pass
+#'
+#' Computes several statistics of the elevations of the points in each cell of a grid in a single
+#' pass over the point cloud, e.g. a canopy height model, the point density and the mean height
+#' at once. The cells are the same as in \link{grid_canopy} and \link{grid_density}. Only the
+#' cells that contain at least one point are returned.
+#'
+#' @param las An object of class \link{LAS}
+#' @param res numeric. The size of a grid cell in LiDAR data coordinates units.
+#' @param stats character. The statistics to compute among \code{"max"}, \code{"min"},
+#' \code{"count"}, \code{"sum"}, \code{"mean"} and \code{"sumsq"} (sum of the squares).
+#' Each statistic can be followed by \code{"_first"} to use only the first returns e.g.
+#' \code{"count_first"}. The columns are named after \code{names(stats)} if any, otherwise
+#' after the statistics.
+#' @param subcircle numeric. Radius of the circles. To obtain fewer empty pixels the algorithm
+#' can replace each return with a circle composed of 8 points (see \link{grid_canopy}).
+#'
+#' @return Returns a \code{data.table} of class \code{lasmetrics} with the coordinates of the
+#' cells and one column per statistic. The statistics of a cell with no point to aggregate (e.g.
+#' no first return) are NA, or 0 for the counts.
+#'
+#' @examples
+#' LASfile <- system.file("extdata", "Megaplot.laz", package="lidR")
+#' las = readLAS(LASfile, select = "xyzr")
+#'
+#' # Canopy height model, point density and mean height in a single pass
+#' stats = grid_stats(las, 2, c(Z = "max", n = "count", zmean = "mean", nfirst = "count_first"))
+#' plot(stats, "zmean")
+#' @seealso
+#' \link[lidR:grid_canopy]{grid_canopy}
+#' \link[lidR:grid_density]{grid_density}
+#' @export
+grid_stats = function(las, res, stats, subcircle = 0)
+{
+  stopifnotlas(las)
+  assertive::assert_is_a_number(res)
+  assertive::assert_all_are_positive(res)
+  assertive::assert_is_character(stats)
+  assertive::assert_is_a_number(subcircle)
+  assertive::assert_all_are_non_negative(subcircle)
+
+  return(rasterize_stats(las, res, stats, subcircle))
+}
+
+# grid_stats without checks. If core = c(xmin, ymin, xmax, ymax) is given only the cells whose
+# center is in this rectangle are computed.
+rasterize_stats = function(las, res, stats, subcircle = 0, core = NULL)
+{
+  layers <- names(stats)
+  if (is.null(layers)) layers <- stats
+  layers[layers == ""] <- stats[layers == ""]
+
+  ret = C_rasterize(las, res, unname(stats), layers, subcircle, core)
+  data.table::setDT(ret)
+  as.lasmetrics(ret, res)
+  return(ret)
+}
@@ -113,11 +113,9 @@ grid_terrain.LAS = function(x, res = 1, method, k = 10L, p = 2, model = gstat::v
   if (!"Classification" %in% names(x@data))
     stop("LAS object does not contain 'Classification' data")
 
-  if (fast_countequal(x@data$Classification, 2L) == 0)
+  if (fast_summary(x@data$Classification, equal = 2L)$equal == 0)
     stop("No ground points found. Impossible to compute a DTM.", call. = F)
 
-  ground = x@data[Classification == LASGROUND, .(X,Y,Z)]
-
   # =================================
   # Find where to interpolate the DTM
   # =================================
@@ -159,7 +157,16 @@ grid_terrain.LAS = function(x, res = 1, method, k = 10L, p = 2, model = gstat::v
 
   verbose("Interpolating ground points...")
 
-  Zg = interpolate(ground, grid, method, k, p, model, wbuffer = !has_buffer)
+  # knnidw works on a view of the ground points of the point cloud (no copy)
+  if (method == "knnidw")
+  {
+    Zg = interpolate_knnidw_las(x, grid, k, p)
+  }
+  else
+  {
+    ground = x@data[Classification == LASGROUND, .(X,Y,Z)]
+    Zg = interpolate(ground, grid, method, k, p, model, wbuffer = !has_buffer)
+  }
   grid[, Z := round(Zg, 3)][]
 
   if (keep_lowest)
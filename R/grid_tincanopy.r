@@ -98,7 +98,7 @@ grid_tincanopy.LAS = function(x, res = 0.5, thresholds =  c(0,2,5,10,15), max_ed
   if (!"ReturnNumber" %in% names(x@data))
      stop("No column 'ReturnNumber' found. This field is needed to extract first returns", call. = FALSE)
 
-  if (fast_countequal(x@data$ReturnNumber, 1) == 0)
+  if (fast_summary(x@data$ReturnNumber, equal = 1)$equal == 0)
     stop("No first returns found. Aborted.", call. = FALSE)
 
   if (length(thresholds) == 1 & thresholds[1] == 0)
@@ -1,6 +1,7 @@
 lasaggregate = function(.las, by, call, res, start, colnames, splitlines, debug, name = "")
 {
-  . <- NULL
+  . <- voxel <- NULL
+  voxels <- NULL
 
   if (is(call, "name"))
     call = eval(call)
@@ -35,8 +36,11 @@ lasaggregate = function(.las, by, call, res, start, colnames, splitlines, debug,
     if(!is.numeric(start)) stop("Parameter 'start' should be numeric", call. = FALSE)
     if(3 != length(start)) stop("Parameter 'start' should have a length of 3", call. = FALSE)
 
+    # A single integer voxel id is much cheaper to group by than three doubles. The voxels are
+    # numbered by order of first appearance like the groups of data.table.
     ._class = "lasmetrics3d"
-    by = group_grid_3d(.las@data$X, .las@data$Y, .las@data$Z, res, start)
+    voxels = C_voxelize(.las@data$X, .las@data$Y, .las@data$Z, res, start)
+    by = list(voxel = voxels$voxel)
   }
   # Aggregation on hexagonal cells (grid_hexametrics)
   else if(by == "HEXA")
@@ -109,6 +113,15 @@ lasaggregate = function(.las, by, call, res, start, colnames, splitlines, debug,
 
   stat <- .las@data[, if (!anyNA(.BY)) c(eval(call)), by = by]
 
+  if (!is.null(voxels) && "voxel" %in% names(stat))
+  {
+    # Same names than the groups of group_grid_3d so the metrics named X, Y or Z are not
+    # overwritten. The columns are renamed below.
+    stat[, c("Xgrid", "Ygrid", "Zgrid") := list(voxels$X[voxel], voxels$Y[voxel], voxels$Z[voxel])]
+    stat[, voxel := NULL]
+    data.table::setcolorder(stat, c("Xgrid", "Ygrid", "Zgrid", setdiff(names(stat), c("Xgrid", "Ygrid", "Zgrid"))))
+  }
+
   n = names(stat)
   n[1:length(colnames)] = colnames
 
@@ -144,8 +144,8 @@ classify_from_shapefile = function(.las, shapefile, field = NULL)
   {
     verbose("Analysing the polygons...")
 
-    # Extract the coordinates of each polygon as a list.
-    # The list has 2 levels of depth because of multi part polygons
+    # Extract the coordinates of each polygon as a list of rings.
+    # The list has 2 levels of depth because of multi part polygons and holes
     xcoords = lapply(polys@polygons,
                      function(x)
                      {
@@ -158,47 +158,24 @@ classify_from_shapefile = function(.las, shapefile, field = NULL)
                        lapply(x@Polygons, function(x){x@coords[,2]})
                      })
 
-    is_hole = lapply(polys@polygons,
-                     function(x)
-                     {
-                       lapply(x@Polygons, function(x){x@hole})
-                     })
-
-    # The reduction to 1 level of depth list will cause loss of information
-    # for multi-part polygon. Here we need to retrieve the real IDs of each polygon
-    # before reducing to 1 level of depth
-    i = 0
-    lengths = unlist(lapply(xcoords, length))
-    idpolys = unlist(lapply(lengths, function(x){i <<- i + 1 ; rep.int(i,x)}))
-
-    # Make the lists 1 level depth
-    xcoords = unlist(xcoords, recursive = FALSE)
-    ycoords = unlist(ycoords, recursive = FALSE)
-
-    is_hole = unlist(is_hole)
-    is_hole = c(FALSE, is_hole)
-
-    # Return the id of each polygon
+    # Return the id of each polygon. The holes and the multi part polygons are handled
+    # internally: a point in a hole is not in the polygon.
     verbose("Testing whether points fall in a given polygon...")
 
-    ids = C_points_in_polygons(xcoords, ycoords, .las@data$X, .las@data$Y, LIDROPTIONS("progress"))
+    ids = C_points_in_polygons(xcoords, ycoords, .las@data$X, .las@data$Y, LIDROPTIONS("progress"), spatial_index(.las))
 
     if (method == 1)
     {
       verbose("Retrieving correspondances in the table of attributes...")
 
       inpoly = ids > 0
-      inhole = is_hole[ids + 1]
-      inpoly.nothole = inpoly & !inhole
-
-      id = idpolys[ids[inpoly.nothole]]
-      values[inpoly.nothole] = polys@data[, field][id]
+      values[inpoly] = polys@data[, field][ids[inpoly]]
 
       verbose(glue("Assigned the value of field {field} from the table of attibutes to the points"))
     }
     else if (method == 2)
     {
-      values = ids > 0 & !is_hole[ids + 1]
+      values = ids > 0
       verbose("Assigned a boolean value to the points")
     }
     else
@@ -74,49 +74,21 @@ lasfilterdecimate = function(.las, density, homogenize = TRUE, res = 5, use_puls
   assertive::assert_all_are_positive(res)
   assertive::assert_is_a_bool(use_pulse)
 
-  pulseID <- gpstime <- NULL
-
   if(use_pulse & !"pulseID" %in% names(.las@data))
   {
     warning("No 'pulseID' field found.", call. = FALSE)
     use_pulse = FALSE
   }
 
-  npoints = nrow(.las@data)
-
-  if(homogenize == FALSE)
-  {
+  if (homogenize == FALSE)
     n = round(density*area(.las))
-
-    if (use_pulse)
-      selected = selected_pulses(.las@data$pulseID, n)
-    else
-      selected = sample(1:nrow(.las@data), n)
-  }
   else
-  {
     n = round(density*res^2)
 
-    by = group_grid(.las@data$X, .las@data$Y, res)
+  pulse = if (use_pulse) .las@data$pulseID else numeric(0)
+  seed  = sample.int(.Machine$integer.max, 1)
 
-    if (use_pulse)
-      selected = .las@data[, .I[selected_pulses(pulseID, n)], by = by]$V1
-    else
-      selected = .las@data[, .I[selected_pulses(1:.N, n)], by = by]$V1
-  }
+  selected = C_lasfilterdecimate(.las@data$X, .las@data$Y, res, n, pulse, use_pulse, seed, homogenize, LIDROPTIONS("threads"))
 
   return(LAS(.las@data[selected], .las@header, .las@crs))
 }
-
-selected_pulses = function(pulseID, n)
-{
-  p = unique(pulseID)
-
-  if(n > length(p))
-    return(rep(TRUE, length(pulseID)))
-
-  selectedPulses = sample(p, n)
-  selectedPulses = pulseID %in% selectedPulses
-
-  return(selectedPulses)
-}
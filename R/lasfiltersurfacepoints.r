@@ -24,9 +24,8 @@ lasfiltersurfacepoints = function(las, res)
   assertive::assert_is_a_number(res)
   assertive::assert_all_are_positive(res)
 
-  Z <- NULL
-  by  = group_grid(las@data$X, las@data$Y, res)
-  sub = las@data[las@data[, .I[which.max(Z)], by = by]$V1]
+  selected = C_lasfiltersurfacepoints(las@data$X, las@data$Y, las@data$Z, res, LIDROPTIONS("threads"))
+  sub = las@data[selected]
   las = LAS(sub, las@header, las@crs)
   return(las)
 }
\ No newline at end of file
@@ -119,29 +119,23 @@ lasground_pmf = function(las, ws, th, last_returns = TRUE)
 
   verbose("Progressive morphological filter...")
 
-  for (i in 1:length(ws))
+  # The passes are run natively in a single call: the schedule is printed beforehand
+  for (i in seq_along(ws))
   {
     verbose(glue("Pass {i} of {length(ws)}..."))
     verbose(glue("Windows size = {ws[i]} ; height_threshold = {th[i]}"))
-
-    Z_f = C_MorphologicalOpening(cloud$X, cloud$Y, cloud$Z, ws[i], LIDROPTIONS("progress"))
-
-    # Find indices of the points whose difference between the source and
-    # filtered point clouds is less than the current height threshold
-    diff = cloud$Z - Z_f
-    indices = diff < th[i]
-
-    # Limit filtering to those points currently considered ground returns
-    cloud = cloud[indices]
   }
 
+  ground = C_ProgressiveMorphologicalFilter(cloud$X, cloud$Y, cloud$Z, ws, th, LIDROPTIONS("progress"), LIDROPTIONS("threads"))
+  cloud  = cloud[ground]
+
   idx = cloud$idx
 
   message(glue("{length(idx)} ground points found."))
 
   if ("Classification" %in% names(las@data))
   {
-    nground = fast_countequal(las@data$Classification, 2)
+    nground = fast_summary(las@data$Classification, equal = 2)$equal
 
     if (nground > 0)
     {
@@ -0,0 +1,108 @@
+# ===============================================================================
+#
+# PROGRAMMERS:
+#
+# jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+#
+# COPYRIGHT:
+#
+# Copyright 2018 Jean-Romain Roussel
+#
+# This file is part of lidR R package.
+#
+# lidR is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>
+#
+# ===============================================================================
+
+
+#' Spatial index of a point cloud
+#'
+#' Builds the spatial index of a \code{LAS} object and attaches it to the object. The functions
+#' that look for the neighbourhood of the points, such as \link{lassmooth}, \link{tree_detection},
+#' \link{lasclassify} or \link{lastrees_li2}, reuse this index instead of building their own. A
+#' point cloud is thus indexed only once whatever the number of calls. This is done automatically
+#' the first time an index is needed, so calling \code{lasindex} is only useful to write the index
+#' into a file. The index is invalidated automatically if the coordinates of the points change.\cr\cr
+#' The index can be written into a file with the \code{.lidx} extension next to the las or laz file.
+#' \link{readLAS} loads this file when it reads the las or laz file alone. A \code{.lidx} file is
+#' machine dependent: it should be read on the same kind of computer it was written on.\cr\cr
+#' The coordinates are stored in memory and in the file as the 32-bit integers of the las format,
+#' using the scale factors and the offsets of the header, unless they are not on this lattice (for
+#' example after a reprojection). They are decoded exactly.
+#'
+#' @param las A LAS object
+#' @param file character. The name of a file where the index is written. If NULL the index is
+#' only attached to the object. Use \code{lasindex_file(lasfile)} to get the name of the file
+#' read by \code{readLAS}.
+#'
+#' @return Return nothing. The original object is modified in place by reference.
+#' @export
+#' @examples
+#' LASfile <- system.file("extdata", "MixedConifer.laz", package="lidR")
+#' las = readLAS(LASfile, select = "xyz")
+#'
+#' lasindex(las)
+#' ttops = tree_detection(las, 5)      # Reuses the index
+#' lassmooth(las, 2)                   # Reuses the index
+#'
+#' \dontrun{
+#' lasindex(las, lasindex_file(LASfile))
+#' }
+lasindex = function(las, file = NULL)
+{
+  stopifnotlas(las)
+
+  index = spatial_index(las)
+
+  if (!is.null(file))
+  {
+    assertive::assert_is_a_string(file)
+    C_index_write(index, file, las_quantization(las))
+  }
+
+  return(invisible())
+}
+
+#' @rdname lasindex
+#' @param lasfile character. The name of a las or laz file.
+#' @export
+lasindex_file = function(lasfile)
+{
+  return(paste0(tools::file_path_sans_ext(lasfile), ".lidx"))
+}
+
+# Spatial index of a LAS object. The index is an external pointer attached by reference to the
+# data.table of the point cloud, so the index built by one function is reused by the next ones.
+# It is rebuilt if the coordinates of the points changed or if it was lost, for example by a
+# serialization of the object.
+spatial_index = function(las)
+{
+  index = attr(las@data, "spatial_index")
+
+  if (!is.null(index) && C_index_valid(index, las@data$X, las@data$Y))
+    return(index)
+
+  index = C_index_build(las@data$X, las@data$Y, las_quantization(las))
+  data.table::setattr(las@data, "spatial_index", index)
+  return(index)
+}
+
+# Scale factors and offsets of the header as expected by C_index_build and C_index_write
+las_quantization = function(las)
+{
+  phb = las@header@PHB
+  quantization = c(phb[["X scale factor"]], phb[["Y scale factor"]], phb[["X offset"]], phb[["Y offset"]])
+  if (length(quantization) != 4) quantization = NULL
+  return(quantization)
+}
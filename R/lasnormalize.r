@@ -57,8 +57,10 @@
 #' @param las a LAS object
 #' @param dtm a \link[raster:raster]{RasterLayer} or a \code{lasmetrics} object computed with
 #' \link[lidR:grid_terrain]{grid_terrain}.
-#' @param method character. Used if \code{dtm = NULL}. Can be \code{"knnidw"},
-#' \code{"delaunay"} or \code{"kriging"} (see \link{grid_terrain} for more details).
+#' @param method character. If \code{dtm = NULL} can be \code{"knnidw"}, \code{"delaunay"} or
+#' \code{"kriging"} (see \link{grid_terrain} for more details). If a \code{dtm} is given the
+#' elevation of the ground is the value of the cell containing each point, or it is interpolated
+#' bilinearly between the four closest cells with \code{method = "bilinear"}.
 #' @param k numeric. Used if \code{dtm = NULL}. Number of k-nearest neighbours when the selected
 #' method is either \code{"knnidw"} or \code{"kriging"}.
 #' @param p numeric. Power for inverse distance weighting. Default 2.
@@ -107,16 +109,25 @@ lasnormalize = function(las, dtm = NULL, method, k = 10L, p = 1, model = gstat::
     if (! "Classification" %in% names(las@data))
       stop("No field 'Classification' found.", call. = FALSE)
 
-    if (fast_countequal(las@data$Classification, 2) == 0)
+    if (fast_summary(las@data$Classification, equal = 2)$equal == 0)
       stop("No ground point found in the point cloud.", call. = FALSE)
 
-    Zground = interpolate(las@data[Classification == 2, .(X,Y,Z)], las@data[, .(X,Y)], method = method, k = k, p = p, model = model)
+    if (method == "knnidw")
+      Zground = interpolate_knnidw_las(las, las@data[, .(X,Y)], k, p)
+    else
+    {
+      # The Delaunay interpolation reuses the spatial index of the point cloud
+      index = if (method == "delaunay") spatial_index(las) else NULL
+      Zground = interpolate(las@data[Classification == 2, .(X,Y,Z)], las@data[, .(X,Y)], method = method, k = k, p = p, model = model, index = index)
+    }
 
     isna = is.na(Zground)
     nnas = sum(isna)
 
     if(nnas > 0)
       stop(glue("{nnas} points were not normalizable. Process aborded."), call. = F)
+
+    Znorm = roundc(las@data$Z - Zground, 3L, TRUE)
   }
   else
   {
@@ -126,18 +137,16 @@ lasnormalize = function(las, dtm = NULL, method, k = 10L, p = 1, model = gstat::
     if(!is(dtm, "RasterLayer"))
       stop("The terrain model is not a RasterLayer or a lasmetrics", call. = F)
 
-    #xres = raster::res(dtm)[1]
-    #xmin = dtm@extent@xmin
-    #ymin = dtm@extent@ymin
-    #dtm  = raster::as.matrix(dtm)
-    #Zground = fast_extract(dtm, las@data$X, las@data$Y, xmin, ymin, xres) # 15 times faster than raster::extract + much memory effcient
-    Zground = raster::extract(dtm, las@data[, .(X,Y)])
+    bilinear = !missing(method) && method == "bilinear"
+    res = raster::res(dtm)
+    ext = raster::extent(dtm)
+    Znorm = C_lasnormalize(las@data$X, las@data$Y, las@data$Z, raster::as.matrix(dtm), ext@xmin, ext@ymax, res[1], res[2], bilinear, 3L, LIDROPTIONS("threads"))
 
-    isna = is.na(Zground)
-    nnas = sum(isna)
-
-    if(nnas > 0)
+    if (anyNA(Znorm))
+    {
+      nnas = sum(is.na(Znorm))
       stop(glue("{nnas} points were not normalizable because the DTM contained NA values. Process aborded."), call. = F)
+    }
   }
 
   if (!copy)
@@ -145,14 +154,14 @@ lasnormalize = function(las, dtm = NULL, method, k = 10L, p = 1, model = gstat::
     if (!"Zref" %in% names(las@data))
       las@data[, Zref := Z]
 
-    las@data[, Z := round(Z - Zground, 3)]
+    las@data[, Z := Znorm]
     lasupdateheader(las)
     return(invisible())
   }
   else
   {
     norm = data.table::copy(las@data)
-    norm[, Z := round(Z - Zground, 3)]
+    norm[, Z := Znorm]
     return(LAS(norm, las@header, las@crs))
   }
 }
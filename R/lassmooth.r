@@ -46,12 +46,24 @@ lassmooth = function(las, size, method = c("average", "gaussian"), shape = c("ci
   if (method == "average") method = 1  else method = 2
   if (method == "circle") shape = 1 else shape = 2
 
-  Zs = C_lassmooth(las, size, method, shape, sigma)
-
   if (!"Zraw" %in% names(las@data))
-    las@data[, Zraw := Z]
+  {
+    # The raw elevations become the column Zraw without copy and the smoothed elevations are
+    # written directly into a new column Z, put back at the position of the former one.
+    cols = c(names(las@data), "Zraw")
+    data.table::setnames(las@data, "Z", "Zraw")
+    las@data[, Z := numeric(.N)]
+    data.table::setcolorder(las@data, cols)
+
+    C_lassmooth(las@data$X, las@data$Y, las@data$Zraw, size, method, shape, sigma, LIDROPTIONS("threads"), las@data$Z, spatial_index(las))
+  }
+  else
+  {
+    Zs = C_lassmooth(las@data$X, las@data$Y, las@data$Z, size, method, shape, sigma, LIDROPTIONS("threads"), NULL, spatial_index(las))
+    las@data[, Z := Zs]
+  }
 
-  las@data[, Z := Zs]
+  return(invisible())
 }
 
 #' @export
@@ -65,6 +65,41 @@ lastrees_dalponte = function(las, chm, treetops, th_tree = 2, th_seed = 0.45, th
   assertive::assert_all_are_in_closed_range(th_seed, 0, 1)
   assertive::assert_all_are_in_closed_range(th_cr, 0, 1)
 
+  Canopy <- raster::as.matrix(chm)
+  Canopy <- t(apply(Canopy, 2, rev))
+  Canopy[is.na(Canopy)] <- -Inf
+
+  Maxima <- treetops_seeds(chm, treetops)
+
+  Crowns = C_lastrees_dalponte(Canopy, Maxima, th_seed, th_cr, th_tree, max_cr)
+  Maxima[Maxima == 0] <- NA
+  Crowns[Crowns == 0] <- NA
+
+  Crowns = raster::raster(apply(Crowns,1,rev))
+  raster::extent(Crowns) = raster::extent(chm)
+
+  if(!missing(las))
+  {
+    field = "treeID"
+    p = list(...)
+    if(!is.null(p$field))
+      field = p$field
+
+    stopif_forbidden_name(field)
+    lasclassify(las, Crowns, field)
+    lasaddextrabytes(las, name = field, desc = "An ID for each segmented tree")
+  }
+
+  if (!extra & !missing(las))
+    return(invisible(NULL))
+  else
+    return(Crowns)
+}
+
+# Matrix of seeds in the layout of the native segmentation kernels (see C_lastrees_dalponte)
+# i.e. the pixels of 'chm' that contain a tree top hold its ID, the other pixels hold 0.
+treetops_seeds = function(chm, treetops)
+{
   if (is(treetops, "data.frame"))
   {
     treetops_df = treetops
@@ -104,35 +139,9 @@ lastrees_dalponte = function(las, chm, treetops, th_tree = 2, th_seed = 0.45, th
   treetops = raster::raster(chm)
   suppressWarnings(treetops[cells] <- treetops_df[[3]])
 
-  Canopy <- raster::as.matrix(chm)
-  Canopy <- t(apply(Canopy, 2, rev))
-  Canopy[is.na(Canopy)] <- -Inf
-
   Maxima <- raster::as.matrix(treetops)
   Maxima <- t(apply(Maxima, 2, rev))
   Maxima[is.na(Maxima)] <- 0
 
-  Crowns = C_lastrees_dalponte(Canopy, Maxima, th_seed, th_cr, th_tree, max_cr)
-  Maxima[Maxima == 0] <- NA
-  Crowns[Crowns == 0] <- NA
-
-  Crowns = raster::raster(apply(Crowns,1,rev))
-  raster::extent(Crowns) = raster::extent(chm)
-
-  if(!missing(las))
-  {
-    field = "treeID"
-    p = list(...)
-    if(!is.null(p$field))
-      field = p$field
-
-    stopif_forbidden_name(field)
-    lasclassify(las, Crowns, field)
-    lasaddextrabytes(las, name = field, desc = "An ID for each segmented tree")
-  }
-
-  if (!extra & !missing(las))
-    return(invisible(NULL))
-  else
-    return(Crowns)
+  return(Maxima)
 }
@@ -47,18 +47,20 @@ lastrees_li = function(las, dt1 = 1.5, dt2 = 2, Zu = 15, hmin = 2, R = 10, ...)
 
   stopif_forbidden_name(field)
 
+  # The IDs are written by the segmentation directly into a new column
+  las@data[, (field) := NA_integer_]
+
   if (las@header@PHB$`Max Z` < hmin)
   {
-    id = rep(NA_integer_, nrow(las@data))
     warning("'hmin' is higher than the highest point. No tree segmented.")
   }
   else
   {
     progress <- LIDROPTIONS("progress")
-    id = C_lastrees_li(las, dt1, dt2, Zu, hmin, R, progress)
+    C_lastrees_li(las, dt1, dt2, Zu, hmin, R, progress, las@data[[field]])
   }
 
-  lasaddextrabytes(las, id, field, "An ID for each segmented tree")
+  lasaddextrabytes(las, name = field, desc = "An ID for each segmented tree")
 
   return(invisible())
 }
\ No newline at end of file
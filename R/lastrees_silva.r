@@ -69,24 +69,16 @@ lastrees_silva = function(las, chm, treetops, max_cr_factor = 0.6, exclusion = 0
 
   stopif_forbidden_name(field)
 
-  . <- R <- X <- Y <- Z <- id <- d <- hmax <- NULL
-
-  ttops = data.table::copy(treetops)
-  data.table::setDT(ttops)
-  data.table::setnames(ttops, names(ttops), c("X", "Y", "Z"))
-
-  chmdt = data.table::setDT(raster::as.data.frame(chm, xy = TRUE, na.rm = T))
-  data.table::setnames(chmdt, names(chmdt), c("X", "Y", "Z"))
+  Canopy <- raster::as.matrix(chm)
+  Canopy <- t(apply(Canopy, 2, rev))
 
   # Voronoi tesselation is nothing else than the nearest neigbour
-  u = C_knn(ttops$X, ttops$Y, chmdt$X, chmdt$Y, 1L)
-  chmdt[, id := u$nn.idx[,1]]
-  chmdt[, d := u$nn.dist[,1]]
+  bbox = raster::extent(chm)
+  Crowns = C_lastrees_silva(Canopy, bbox@xmin, bbox@ymin, raster::res(chm)[1], treetops[[1]], treetops[[2]], max_cr_factor, exclusion, LIDROPTIONS("threads"))
+  Crowns[Crowns == 0] <- NA
 
-  chmdt[, hmax := max(Z), by = id]
-  chmdt = chmdt[Z >= exclusion*hmax & d <= max_cr_factor*hmax, .(X,Y, id)]
-  as.lasmetrics(chmdt, raster::res(chm)[1])
-  crown = as.raster(chmdt)
+  crown = raster::raster(apply(Crowns,1,rev))
+  raster::extent(crown) = raster::extent(chm)
 
   if(!missing(las))
   {
@@ -2,8 +2,12 @@
 #'
 #' Individual tree segmentation using a simple watershed. This method is a
 #' \href{https://en.wikipedia.org/wiki/Watershed_(image_processing)}{watershed segmentation}
-#' method. It is based on the bioconductor package \code{EBIimage}. You need to install this package
-#' to run this method (see its \href{https://github.com/aoles/EBImage}{github page}).
+#' method. By default it is based on the bioconductor package \code{EBIimage}. You need to install
+#' this package to run this method (see its \href{https://github.com/aoles/EBImage}{github page}).
+#' If \code{treetops} is given the segmentation is a marker-controlled watershed computed natively
+#' (\code{EBImage} is not needed): each crown is flooded from a tree top, from the highest pixels to
+#' the lowest ones, until it meets another crown or the threshold \code{th_tree}. In this case
+#' there is exactly one crown per tree top and \code{tol} and \code{ext} are not used.
 #'
 #' @param las An object of the class \code{LAS}. If missing \code{extra} is turned to \code{TRUE}
 #' automatically.
@@ -15,6 +19,9 @@
 #' @param th_tree numeric. Threshold below which a pixel cannot be a tree. Default 2.
 #' @param tol numeric. Tolerance see ?EBImage::watershed.
 #' @param ext numeric. see ?EBImage::watershed.
+#' @param treetops \code{RasterLayer} or \code{data.frame} containing the position of the
+#' trees used as markers. Can be computed with \link[lidR:tree_detection]{tree_detection} or
+#' read from an external file. Default is NULL i.e. the markers are found by \code{EBImage}.
 #' @param ... Supplementary options. Currently \code{field} is supported to change the default name of
 #' the new column.
 #'
@@ -25,7 +32,7 @@
 #'
 #' @export
 #' @family  tree_segmentation
-lastrees_watershed = function(las, chm, th_tree = 2, tol = 1, ext = 1, extra = FALSE, ...)
+lastrees_watershed = function(las, chm, th_tree = 2, tol = 1, ext = 1, extra = FALSE, treetops = NULL, ...)
 {
   field = "treeID"
   p = list(...)
@@ -34,16 +41,29 @@ lastrees_watershed = function(las, chm, th_tree = 2, tol = 1, ext = 1, extra = F
 
   stopif_forbidden_name(field)
 
-  if (!requireNamespace("EBImage", quietly = TRUE))
-    stop("'EBImage' package is needed for this function to work. Please read documentation.", call. = F)
+  if (!is.null(treetops))
+  {
+    Canopy <- raster::as.matrix(chm)
+    Canopy <- t(apply(Canopy, 2, rev))
+    Canopy[is.na(Canopy)] <- -Inf
+
+    Seeds  <- treetops_seeds(chm, treetops)
+    Crowns <- C_lastrees_watershed(Canopy, Seeds, th_tree)
+    Crowns[Crowns == 0] <- NA
+  }
+  else
+  {
+    if (!requireNamespace("EBImage", quietly = TRUE))
+      stop("'EBImage' package is needed for this function to work if 'treetops' is not provided. Please read documentation.", call. = F)
 
-  Canopy <- raster::as.matrix(chm)
-  Canopy <- t(apply(Canopy, 2, rev))
-  Canopy[Canopy < th_tree] <- NA
+    Canopy <- raster::as.matrix(chm)
+    Canopy <- t(apply(Canopy, 2, rev))
+    Canopy[Canopy < th_tree] <- NA
 
-  Crowns = EBImage::watershed(Canopy, tol, ext)
+    Crowns = EBImage::watershed(Canopy, tol, ext)
+    Crowns[is.na(Canopy)] <- NA
+  }
 
-  Crowns[is.na(Canopy)] <- NA
   Crowns = raster::raster(apply(Crowns,1,rev))
   raster::extent(Crowns) = raster::extent(chm)
 
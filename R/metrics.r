@@ -277,8 +277,7 @@ entropy = function(z, by = 1, zmax = NULL)
 	bk = seq(0, ceiling(zmax/by)*by, by)
 
 	# Compute the p for each bin
-	hist = findInterval(z, bk)
-	hist = fast_table(hist, length(bk)-1)
+	hist = fast_summary(z, breaks = bk)$hist
 	hist = hist/sum(hist)
 
 	# Remove bin where there are no points because of log(0)
@@ -340,8 +339,7 @@ stdmetrics_z = function(z, dz = 1)
   else
   {
     breaks = seq(0, zmax, zmax/10)
-    d = findInterval(z, breaks)
-    d = fast_table(d, 10)
+    d = fast_summary(z, breaks = breaks)$hist
     d = d / sum(d)*100
     d = cumsum(d)[1:9]
     d = as.list(d)
@@ -111,10 +111,14 @@ rumple_index.numeric <- function(x, y = NULL, z = NULL, ...)
   rumple = tryCatch(
   {
     X = cbind(x,y,z)
-    dn = suppressMessages(geometry::delaunayn(X[,1:2], options = "QbB"))
-    N = C_tinfo(dn, X)
-    area  = sum(N[,5])
-    parea = sum(N[,6])
+    dn = C_delaunay(x, y)
+
+    if (nrow(dn) == 0)
+      return(NA_real_)
+
+    N = C_tinfo(dn, X, c("xyzarea", "xyarea"))
+    area  = sum(N[,1])
+    parea = sum(N[,2])
     return(area/parea)
   },
   error = function(e)
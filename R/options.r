@@ -1,15 +1,30 @@
+# Accepts whole numbers >= 1 only (2 or 2L but not 2.5). The value is stored as an integer by
+# lidr_options()
+whole_number = function()
+{
+  function(x)
+  {
+    if (!(is.numeric(x) && length(x) == 1 && !is.na(x) && x == round(x) && x >= 1))
+      stop("Allowed values are whole numbers greater or equal to 1", call. = FALSE)
+
+    invisible(TRUE)
+  }
+}
+
 LIDROPTIONS <- settings::options_manager(
   verbose = FALSE,
   progress = FALSE,
   debug = FALSE,
   interactive = TRUE,
   memlimit = 5e8,
+  threads = 1L,
 
   .allowed = list(
     verbose  = bool(),
     debug    = bool(),
     progress = bool(),
-    interactive = bool()
+    interactive = bool(),
+    threads  = whole_number()
   )
 )
 
@@ -26,6 +41,9 @@ LIDROPTIONS <- settings::options_manager(
 #'  \item{\code{verbose} (\code{logical}) Make the package "talkative". }
 #'  \item{\code{progress} (\code{logical}) Display progress bar when available. }
 #'  \item{\code{debug} (\code{logical}) Switch the package to debug mode when available.}
+#'  \item{\code{threads} (\code{integer}) Number of threads used by the functions that support
+#'  multi-threading (\link{lassmooth}, \link{lasground}, \link{tree_detection}, \link{lastrees_silva},
+#'  \link{grid_metrics} and the \code{knnidw} interpolation). Requires a compiler that supports OpenMP. Default is 1.}
 #' }
 #'
 #' @examples
@@ -39,9 +57,62 @@ LIDROPTIONS <- settings::options_manager(
 lidr_options <- function(...)
 {
   settings::stop_if_reserved(...)
-  LIDROPTIONS(...)
+  args = list(...)
+
+  if (!is.null(args[["threads"]]))
+  {
+    whole_number()(args[["threads"]])
+    args[["threads"]] = as.integer(args[["threads"]])
+  }
+
+  do.call(LIDROPTIONS, args)
 }
 
 #' @export
 #' @rdname lidr_options
 lidr_reset = function() { settings::reset(LIDROPTIONS) }
+
+#' Instrumentation of the native functions
+#'
+#' Records the time spent in the main stages of the native (C++) functions of lidR to find where
+#' the time goes in a slow processing: the construction of the spatial indexes, the queries, the
+#' conversion of the inputs and the creation of the outputs. \code{lidr_instrument_start} enables
+#' the records, \code{lidr_instrument_stop} disables them and returns what was recorded since
+#' the start. When a \code{LAScatalog} is processed on a single core each record is labelled with
+#' the name of its cluster. The records of the clusters processed by other R processes are lost.
+#'
+#' @return \code{lidr_instrument_stop} returns a \code{data.frame} with one row per stage of each
+#' call of a native function: \code{call} (number of the call), \code{label} (name of the cluster),
+#' \code{kernel} (name of the native function), \code{stage}, \code{time} (wall-clock time in
+#' seconds), \code{count} (number of items processed: points, queries or cells) and \code{scanned}
+#' (number of points examined by the spatial index to answer the queries).
+#'
+#' @examples
+#' LASfile <- system.file("extdata", "MixedConifer.laz", package="lidR")
+#' las = readLAS(LASfile, select = "xyz")
+#'
+#' lidr_instrument_start()
+#' ttops = tree_detection(las, 5)
+#' chm = grid_canopy(las, 1)
+#' records = lidr_instrument_stop()
+#'
+#' # Number of points examined per query
+#' queries = records[records$stage == "queries",]
+#' queries$scanned / queries$count
+#'
+#' # Time per cluster and stage of a catalog
+#' # aggregate(time ~ label + stage, records, sum)
+#' @export
+lidr_instrument_start = function()
+{
+  C_instrumentation_start()
+  return(invisible())
+}
+
+#' @export
+#' @rdname lidr_instrument_start
+lidr_instrument_stop = function()
+{
+  records = C_instrumentation_collect(TRUE)
+  return(data.frame(records, stringsAsFactors = FALSE))
+}
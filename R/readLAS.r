@@ -209,6 +209,17 @@ streamLAS.character = function(x, ofile, select = "*", filter = "")
 
   las <- LAS(data, header, check = FALSE)
 
+  # Spatial index written next to the file (see lasindex)
+  lidx = lasindex_file(ifiles[1])
+
+  if (length(ifiles) == 1 && nchar(filter) == 0 && file.exists(lidx))
+  {
+    index = tryCatch(C_index_read(lidx), error = function(e) NULL)
+
+    if (!is.null(index))
+      data.table::setattr(las@data, "spatial_index", index)
+  }
+
   if (P)  laspulse(las)
   if (Fl) lasflightline(las, 30)
   if (C)  suppressWarnings(lascolor(las))
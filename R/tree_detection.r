@@ -35,13 +35,22 @@
 #' @param x A object of class \code{LAS} or an object representing a canopy height model
 #' such as a \code{RasterLayer} or a \code{lasmetrics} or a \code{matrix}.
 #' @param ws numeric. Size of the moving window used to the detect the local maxima. On
-#' a raster-like object this size is in pixels and should be an odd number larger than 3.
-#' On a raw point cloud this size is in the point cloud units (usually meters).
+#' a raw point cloud this size is in the point cloud units (usually meters). It can also be
+#' a function that computes the size of the window of each point from its height, for
+#' example \code{function(z) 0.1 * z + 3}. On a raster-like object this size is in pixels
+#' and should be an odd number larger than 3. It can be a matrix (or a \code{RasterLayer})
+#' of the same size as the image giving the size of the window of each pixel, or a function
+#' of the heights of the pixels. The sizes returned by a function are rounded to the
+#' nearest odd number.
 #' @param hmin numeric. Minimum height of a tree. Threshold below which a pixel or a point
 #' cannot be a local maxima. Default 2.
+#' @param shape character. Shape of the moving window on a raw point cloud: \code{"square"}
+#' of size \code{ws} or \code{"circular"} of diameter \code{ws}. Ignored for raster-like objects.
 #'
 #' @return A \code{data.table} with the coordinates of the tree tops (X, Y, Z) if the input
-#' is a point cloud, or a RasterLayer if the input is a raster-like object.
+#' is a point cloud, or a RasterLayer if the input is a raster-like object. If the
+#' point cloud has a column 'buffer', such as the clusters of a \code{LAScatalog} in
+#' \link{catalog_apply}, the tree tops located in the buffer are not returned.
 #' @export
 #'
 #' @examples
@@ -52,6 +61,11 @@
 #'
 #' ttops = tree_detection(las, 5)
 #'
+#' # circular windows growing with the height of the trees
+#'
+#' f = function(z) 0.1 * z + 3
+#' ttops = tree_detection(las, f, shape = "circular")
+#'
 #' plot(las)
 #' with(ttops, rgl::points3d(X, Y, Z, col = "red", size = 5, add = TRUE))
 #'
@@ -66,29 +80,40 @@
 #'
 #' raster::plot(chm, col = height.colors(30))
 #' raster::plot(ttops, add = TRUE, col = "black", legend = FALSE)
-tree_detection = function(x, ws, hmin = 2)
+tree_detection = function(x, ws, hmin = 2, shape = c("square", "circular"))
 {
   UseMethod("tree_detection", x)
 }
 
 #'@export
-tree_detection.LAS = function(x, ws, hmin = 2)
+tree_detection.LAS = function(x, ws, hmin = 2, shape = c("square", "circular"))
 {
-  assertive::assert_is_a_number(ws)
-  assertive::assert_all_are_positive(ws)
+  shape = match.arg(shape)
+
+  if (is.function(ws))
+  {
+    ws = ws(x@data$Z)
+
+    if (!is.numeric(ws) || length(ws) != nrow(x@data))
+      stop("The function 'ws' must return one window size per point.", call. = FALSE)
+  }
+  else
+    assertive::assert_is_a_number(ws)
+
+  assertive::assert_all_are_positive(ws[!is.na(ws)])
   assertive::assert_is_a_number(hmin)
   assertive::assert_all_are_positive(hmin)
 
   . <- X <- Y <- Z <- NULL
-  maxima = C_LocalMaximaPoints(x, ws, hmin)
+  # In a buffered cluster of a catalog the tree tops in the buffer are not returned
+  buffer = x@data[["buffer"]]
+  maxima = C_LocalMaximaPoints(x@data$X, x@data$Y, x@data$Z, ws, hmin, shape == "circular", LIDROPTIONS("threads"), spatial_index(x), buffer)
   return(x@data[maxima, .(X,Y,Z)])
 }
 
 #'@export
-tree_detection.lasmetrics = function(x, ws, hmin = 2)
+tree_detection.lasmetrics = function(x, ws, hmin = 2, shape = c("square", "circular"))
 {
-  assertive::assert_is_a_number(ws)
-  assertive::assert_all_are_positive(ws)
   assertive::assert_is_a_number(hmin)
   assertive::assert_all_are_positive(hmin)
 
@@ -97,15 +122,19 @@ tree_detection.lasmetrics = function(x, ws, hmin = 2)
 }
 
 #'@export
-tree_detection.RasterLayer = function(x, ws, hmin = 2)
+tree_detection.RasterLayer = function(x, ws, hmin = 2, shape = c("square", "circular"))
 {
-  assertive::assert_is_a_number(ws)
-  assertive::assert_all_are_positive(ws)
   assertive::assert_is_a_number(hmin)
   assertive::assert_all_are_positive(hmin)
 
   xx <- raster::as.matrix(x)
   xx <- t(apply(xx, 2, rev))
+
+  if (is(ws, "RasterLayer"))
+    ws <- raster::as.matrix(ws)
+
+  if (is.matrix(ws))
+    ws <- t(apply(ws, 2, rev))
   LM = tree_detection(xx, ws, hmin)
   LM = raster::raster(apply(LM,1,rev))
   raster::extent(LM) = raster::extent(x)
@@ -113,14 +142,47 @@ tree_detection.RasterLayer = function(x, ws, hmin = 2)
 }
 
 #'@export
-tree_detection.matrix = function(x, ws, hmin = 2)
+tree_detection.matrix = function(x, ws, hmin = 2, shape = c("square", "circular"))
 {
-  assertive::assert_is_a_number(ws)
-  assertive::assert_all_are_greater_than_or_equal_to(ws, 3)
-  assertive::assert_all_are_odd(ws)
+  assertive::assert_is_a_number(hmin)
+
+  ws = raster_window_sizes(x, ws)
 
   x[is.na(x)] <- -Inf
-  LM = C_LocalMaximaMatrix(x, ws, hmin)
+  LM = C_LocalMaximaMatrix(x, ws, hmin, LIDROPTIONS("threads"))
   LM[LM == 0] <- NA
   return(LM)
-}
\ No newline at end of file
+}
+
+# Window sizes of the raster-based method: a single size, one size per pixel or a function
+# of the heights of the pixels whose results are rounded to the nearest odd number. The NA
+# pixels cannot be local maxima.
+raster_window_sizes = function(x, ws)
+{
+  if (is.function(ws))
+  {
+    ws = ws(x)
+
+    if (!is.numeric(ws) || length(ws) != length(x))
+      stop("The function 'ws' must return one window size per pixel.", call. = FALSE)
+
+    ws = 2*round((ws-1)/2) + 1
+  }
+  else if (is.matrix(ws))
+  {
+    if (any(dim(ws) != dim(x)))
+      stop("The matrix 'ws' must have the size of the image.", call. = FALSE)
+  }
+  else
+    assertive::assert_is_a_number(ws)
+
+  sizes = ws[!is.na(ws)]
+
+  if (length(sizes) > 0)
+  {
+    assertive::assert_all_are_greater_than_or_equal_to(sizes, 3)
+    assertive::assert_all_are_odd(sizes)
+  }
+
+  return(as.integer(ws))
+}
@@ -25,7 +25,8 @@
 #
 # ===============================================================================
 
-interpolate = function(points, coord, method, k, p, model, wbuffer = TRUE)
+# index is the spatial index of coord if any (see spatial_index)
+interpolate = function(points, coord, method, k, p, model, wbuffer = TRUE, index = NULL)
 {
   . <- X <- Y <- Z <- NULL
 
@@ -38,11 +39,7 @@ interpolate = function(points, coord, method, k, p, model, wbuffer = TRUE)
   ndup_xyz = sum(dup_xyz)
   ndup_xy  = sum(dup_xy & !dup_xyz)
 
-  if (ndup_xyz > 0)
-    warning(glue("There were {ndup_xyz} degenerated ground points. Some X Y Z coordinates were repeated. They were removed."), call. = FALSE)
-
-  if (ndup_xy > 0)
-    warning(glue("There were {ndup_xy} degenerated ground points. Some X Y coordinates were repeated but with different Z coordinates. min Z were retained."), call. = FALSE)
+  warn_degenerated(ndup_xyz, ndup_xy)
 
   if (ndup_xy > 0 | ndup_xyz > 0)
     points = points[, .(Z = min(Z)), by = .(X,Y)]
@@ -56,14 +53,14 @@ interpolate = function(points, coord, method, k, p, model, wbuffer = TRUE)
   {
     verbose("[using Delaunay triangulation]")
 
-    z = interpolate_delaunay(points, coord)
+    z = interpolate_delaunay(points, coord, index = index)
 
     isna = is.na(z)
     nnas = sum(isna)
 
     if (nnas > 0 & k > 0)
     {
-      z[isna] <- C_knnidw(coord$X[!isna], coord$Y[!isna], z[!isna], coord$X[isna], coord$Y[isna], 1, 1)
+      z[isna] <- C_knnidw(coord$X[!isna], coord$Y[!isna], z[!isna], coord$X[isna], coord$Y[isna], 1, 1, LIDROPTIONS("threads"))
 
       if(wbuffer)
         message(glue("{nnas} points outside the convex hull of the triangulation were interpolated using the nearest neighbour."))
@@ -81,10 +78,37 @@ interpolate = function(points, coord, method, k, p, model, wbuffer = TRUE)
 
 interpolate_knnidw = function(points, coord, k, p)
 {
-  z = C_knnidw(points$X, points$Y, points$Z, coord$X, coord$Y, k, p)
+  z = C_knnidw(points$X, points$Y, points$Z, coord$X, coord$Y, k, p, LIDROPTIONS("threads"))
+  return(z)
+}
+
+# Same as interpolate(las@data[Classification == 2], coord, "knnidw", k, p) without copying
+# the ground points: the kernel works on a view of the columns of the point cloud.
+interpolate_knnidw_las = function(las, coord, k, p)
+{
+  if (dim(coord)[1] == 0)
+    return(numeric(0))
+
+  verbose("[using inverse distance weighting]")
+
+  z = C_knnidw_las(las, coord$X, coord$Y, k, p, LASGROUND, LIDROPTIONS("threads"))
+
+  dup = attr(z, "duplicates")
+  attr(z, "duplicates") <- NULL
+  warn_degenerated(dup[1], dup[2])
+
   return(z)
 }
 
+warn_degenerated = function(ndup_xyz, ndup_xy)
+{
+  if (ndup_xyz > 0)
+    warning(glue("There were {ndup_xyz} degenerated ground points. Some X Y Z coordinates were repeated. They were removed."), call. = FALSE)
+
+  if (ndup_xy > 0)
+    warning(glue("There were {ndup_xy} degenerated ground points. Some X Y coordinates were repeated but with different Z coordinates. min Z were retained."), call. = FALSE)
+}
+
 interpolate_kriging = function(points, coord, model, k)
 {
   X <- Y <- Z <- NULL
@@ -99,44 +123,17 @@ interpolate_kriging = function(points, coord, model, k)
   return(x$var1.pred)
 }
 
-interpolate_delaunay <- function(points, coord, th = 0)
+interpolate_delaunay <- function(points, coord, th = 0, index = NULL)
 {
-  pitfree = th > 0  # specific case if using khosravipour algorithm in grid_tincanopy
-
   verbose("Delaunay triangulation...")
 
-  X <- as.matrix(points)
-  Y <- as.matrix(coord)
-
-  dn   <- suppressMessages(geometry::delaunayn(X[,1:2], options = "QbB"))
-
-  # geometry::trimesh(dn, X, asp = 1)
-
-  verbose("Searching for the enclosing Delaunay convex hull...")
-
-  idx  <- C_tsearch(points$X, points$Y, dn, coord$X, coord$Y, LIDROPTIONS("progress"))
-
-  #uidx <- unique(idx)
-  #uidx <- uidx[!is.na(uidx)]
-
-  #active <- dn[uidx,]
-  #active <- cbind(active, uidx)
+  dn <- C_delaunay(points$X, points$Y)
 
+  # If th > 0 the triangles larger than th are removed on the fly
+  # (specific case if using khosravipour algorithm in grid_tincanopy)
   verbose("Rasterizing the triangulation...")
 
-  N = C_tinfo(dn, X)
-  N = N[idx,]
-
-  z = -(Y[,1] * N[,1] + Y[,2] * N[,2] + N[,4]) / N[,3]
-
-  if (pitfree)
-  {
-    verbose("Removing triangles larger than threshold...")
-
-    delete = N[,7] > th
-    delete[is.na(delete)] = FALSE
-    z[delete] = NA
-  }
+  z <- C_tinterpolate(points$X, points$Y, points$Z, dn, coord$X, coord$Y, th, LIDROPTIONS("progress"), index)
 
   return(z)
-}
\ No newline at end of file
+}
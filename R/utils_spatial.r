@@ -43,7 +43,8 @@
 setMethod("extent", "LAS",
 	function(x, ...)
 	{
-		return(raster::extent(min(x@data$X), max(x@data$X), min(x@data$Y), max(x@data$Y)))
+		r = fast_summary(list(x@data$X, x@data$Y))
+		return(raster::extent(r[[1]]$min, r[[1]]$max, r[[2]]$min, r[[2]]$max))
 	}
 )
 
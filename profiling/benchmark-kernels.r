@@ -0,0 +1,231 @@
+# Micro-benchmarks of the native kernels of lidR on synthetic point clouds
+#
+# Each kernel is called directly (lidR:::C_*) on point clouds of controlled size and density so
+# the timings measure the C++ code and not the R glue. The results are written in a csv file
+# with one row per kernel, size and number of threads:
+#
+#   kernel, npoints, density, threads, time (median of the runs, seconds), throughput (points
+#   per second), rmem (peak memory allocated by R in MB), rss (peak resident memory of the
+#   process in MB, Linux only), version (lidR), date
+#
+# Usage:
+#   Rscript profiling/benchmark-kernels.r [output.csv] [sizes] [threads] [runs]
+#   Rscript profiling/benchmark-kernels.r compare old.csv new.csv [tolerance]
+#
+# e.g. Rscript profiling/benchmark-kernels.r bench-1.7.0.csv 1e5,1e6 1,2,4 5
+#
+# The second form compares two result files and lists the kernels that became slower by more
+# than 'tolerance' (default 0.1 i.e. 10%). It exits with status 1 if there is a regression.
+
+library(lidR)
+
+DENSITY = 20
+
+# Synthetic forest: hills of ~10 m look like crowns, with a flat ground 20% of the points
+synthetic_cloud = function(n, density = DENSITY)
+{
+  set.seed(42)
+  side = sqrt(n/density)
+  X = stats::runif(n, 0, side)
+  Y = stats::runif(n, 0, side)
+  Z = 20 * (0.5 + 0.5 * sin(X/3) * cos(Y/3)) + stats::rnorm(n, 0, 0.3)
+  ground = seq(1, n, by = 5)
+  Z[ground] = stats::rnorm(length(ground), 0, 0.1)
+  Z[Z < 0] = 0
+  dt = data.table::data.table(X, Y, Z)
+  return(suppressWarnings(LAS(dt)))
+}
+
+chm_matrix = function(las, res = 0.5)
+{
+  chm = data.table::as.data.table(lidR:::C_grid_canopy(las, res))
+  as.lasmetrics(chm, res)
+  m = raster::as.matrix(as.raster(chm))
+  m = t(apply(m, 2, rev))
+  m[is.na(m)] <- -Inf
+  return(m)
+}
+
+square_polygons = function(side, npoly = 100)
+{
+  k = ceiling(sqrt(npoly))
+  w = side / k
+  centers = expand.grid(x = (seq_len(k) - 0.5) * w, y = (seq_len(k) - 0.5) * w)
+  h = 0.4 * w
+  xs = lapply(seq_len(nrow(centers)), function(i) list(centers$x[i] + c(-h, h, h, -h, -h)))
+  ys = lapply(seq_len(nrow(centers)), function(i) list(centers$y[i] + c(-h, -h, h, h, -h)))
+  return(list(x = xs, y = ys))
+}
+
+# Each kernel has a setup function that prepares the inputs of a given point cloud (not timed)
+# and returns the function timed for a given number of threads. 'threaded' tells whether the
+# kernel has a ncpu parameter.
+kernels = list(
+  C_knn = list(threaded = TRUE, setup = function(las)
+  {
+    X = las@data$X ; Y = las@data$Y
+    function(threads) lidR:::C_knn(X, Y, X, Y, 10L, threads)
+  }),
+
+  C_lassmooth = list(threaded = TRUE, setup = function(las)
+  {
+    X = las@data$X ; Y = las@data$Y ; Z = las@data$Z
+    function(threads) lidR:::C_lassmooth(X, Y, Z, 2, 1L, 1L, 1, threads)
+  }),
+
+  C_MorphologicalOpening = list(threaded = TRUE, setup = function(las)
+  {
+    X = las@data$X ; Y = las@data$Y ; Z = las@data$Z
+    function(threads) lidR:::C_MorphologicalOpening(X, Y, Z, 3, FALSE, threads)
+  }),
+
+  C_tsearch = list(threaded = FALSE, setup = function(las)
+  {
+    X = las@data$X ; Y = las@data$Y
+    i = seq(1, length(X), by = 50)
+    xi = X[i] ; yi = Y[i]
+    D = lidR:::C_delaunay(xi, yi)
+    function(threads) lidR:::C_tsearch(xi, yi, D, X, Y)
+  }),
+
+  C_lastrees_dalponte = list(threaded = FALSE, setup = function(las)
+  {
+    image = chm_matrix(las)
+    seeds = lidR:::C_LocalMaximaMatrix(image, 5L, 2)
+    seeds[seeds != 0] = seq_len(sum(seeds != 0))
+    function(threads) lidR:::C_lastrees_dalponte(image, seeds, 0.45, 0.55, 2, 20)
+  }),
+
+  C_lastrees_li2 = list(threaded = FALSE, setup = function(las)
+  {
+    output = rep(NA_integer_, nrow(las@data))
+    function(threads) lidR:::C_lastrees_li2(las, 1.5, 2, 15, 2, 2, 10, FALSE, output)
+  }),
+
+  C_grid_canopy = list(threaded = FALSE, setup = function(las)
+  {
+    function(threads) lidR:::C_grid_canopy(las, 1, 0.2)
+  }),
+
+  C_points_in_polygons = list(threaded = FALSE, setup = function(las)
+  {
+    X = las@data$X ; Y = las@data$Y
+    poly = square_polygons(max(X))
+    function(threads) lidR:::C_points_in_polygons(poly$x, poly$y, X, Y)
+  })
+)
+
+# Peak resident memory of the process in MB. Writing 5 in clear_refs resets the peak (Linux).
+reset_rss = function()
+{
+  if (file.exists("/proc/self/clear_refs"))
+    try(cat("5", file = "/proc/self/clear_refs"), silent = TRUE)
+}
+
+peak_rss = function()
+{
+  if (!file.exists("/proc/self/status"))
+    return(NA_real_)
+
+  status = readLines("/proc/self/status")
+  hwm = grep("^VmHWM", status, value = TRUE)
+
+  if (length(hwm) == 0)
+    return(NA_real_)
+
+  return(as.numeric(gsub("[^0-9]", "", hwm)) / 1024)
+}
+
+run_kernel = function(f, threads, runs)
+{
+  f(threads) # warm up
+
+  times = numeric(runs)
+  rmem  = numeric(runs)
+  rss   = numeric(runs)
+
+  for (i in seq_len(runs))
+  {
+    invisible(gc(reset = TRUE))
+    reset_rss()
+    times[i] = system.time(f(threads))[["elapsed"]]
+    g = gc()
+    rmem[i] = sum(g[, 6])
+    rss[i]  = peak_rss()
+  }
+
+  return(c(time = stats::median(times), rmem = max(rmem), rss = max(rss)))
+}
+
+run_benchmarks = function(sizes, threads, runs)
+{
+  out = list()
+
+  for (n in sizes)
+  {
+    las = synthetic_cloud(n)
+
+    for (name in names(kernels))
+    {
+      kernel = kernels[[name]]
+      f = kernel$setup(las)
+      nthreads = if (kernel$threaded) threads else 1L
+
+      for (t in nthreads)
+      {
+        r = run_kernel(f, t, runs)
+        row = data.frame(kernel = name, npoints = n, density = DENSITY, threads = t,
+                         time = r[["time"]], throughput = n / r[["time"]],
+                         rmem = r[["rmem"]], rss = r[["rss"]],
+                         version = as.character(utils::packageVersion("lidR")),
+                         date = format(Sys.time(), "%Y-%m-%d %H:%M:%S"),
+                         stringsAsFactors = FALSE)
+
+        cat(sprintf("%-24s n = %-9g threads = %-2d %8.3f s  %10.0f pts/s\n", name, n, t, row$time, row$throughput))
+        out[[length(out) + 1]] = row
+      }
+    }
+  }
+
+  return(do.call(rbind, out))
+}
+
+compare_benchmarks = function(old, new, tolerance = 0.1)
+{
+  key = c("kernel", "npoints", "threads")
+  m = merge(old[, c(key, "time")], new[, c(key, "time")], by = key, suffixes = c(".old", ".new"))
+  m$ratio = m$time.new / m$time.old
+  m = m[order(-m$ratio), ]
+  print(m, row.names = FALSE)
+
+  slower = m[m$ratio > 1 + tolerance, ]
+
+  if (nrow(slower) > 0)
+  {
+    cat("\nRegressions:\n")
+    print(slower, row.names = FALSE)
+  }
+
+  return(invisible(slower))
+}
+
+args = commandArgs(trailingOnly = TRUE)
+
+if (length(args) > 0 && args[1] == "compare")
+{
+  old = utils::read.csv(args[2], stringsAsFactors = FALSE)
+  new = utils::read.csv(args[3], stringsAsFactors = FALSE)
+  tolerance = if (length(args) > 3) as.numeric(args[4]) else 0.1
+  slower = compare_benchmarks(old, new, tolerance)
+  if (nrow(slower) > 0) quit(status = 1)
+} else
+{
+  output  = if (length(args) > 0) args[1] else "benchmark-kernels.csv"
+  sizes   = if (length(args) > 1) as.numeric(strsplit(args[2], ",")[[1]]) else c(1e5, 1e6)
+  threads = if (length(args) > 2) as.integer(strsplit(args[3], ",")[[1]]) else c(1L, 2L, 4L)
+  runs    = if (length(args) > 3) as.integer(args[4]) else 5L
+
+  res = run_benchmarks(sizes, threads, runs)
+  utils::write.csv(res, output, row.names = FALSE)
+  cat("Results written in", output, "\n")
+}
@@ -31,6 +31,110 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 #include "QuadTree.h"
 using namespace Rcpp;
 
+// The columns of a LAS object are either integer or double vectors. The kernels below are
+// written once for both types and read the memory of the R vectors directly so an integer
+// column is never converted into a temporary double vector. The inner loops have no
+// branches and are vectorized by the compiler.
+
+#define DISPATCH(x, kernel, ...) \
+  switch(TYPEOF(x)) \
+  { \
+    case INTSXP: \
+    case LGLSXP: return kernel(INTEGER(x), XLENGTH(x), __VA_ARGS__); \
+    case REALSXP: return kernel(REAL(x), XLENGTH(x), __VA_ARGS__); \
+    default: stop("Internal error: unsupported vector type."); \
+  }
+
+static inline bool is_na(int x) { return x == NA_INTEGER; }
+static inline bool is_na(double x) { return std::isnan(x); }
+
+template<typename T> static int count_equal(const T* x, R_xlen_t n, double t)
+{
+  int count = 0;
+  for (R_xlen_t i = 0 ; i < n ; i++) count += (x[i] == t);
+  return count;
+}
+
+template<typename T> static int count_below(const T* x, R_xlen_t n, double t)
+{
+  int count = 0;
+  for (R_xlen_t i = 0 ; i < n ; i++) count += (x[i] < t) & !is_na(x[i]);
+  return count;
+}
+
+template<typename T> static int count_over(const T* x, R_xlen_t n, double t)
+{
+  int count = 0;
+  for (R_xlen_t i = 0 ; i < n ; i++) count += (x[i] > t);
+  return count;
+}
+
+// Fused summary of a vector: number of NAs, min, max, the number of values equal to, below
+// and over some thresholds and the histogram of the values. All the statistics are computed
+// over the same pass on the vector, block by block, so each block is read once from memory
+// and stays in cache while each statistic is reduced by a branchless loop.
+template<typename T> static List column_summary(const T* x, R_xlen_t n, NumericVector equal, NumericVector below, NumericVector over, NumericVector breaks)
+{
+  const R_xlen_t BLOCK = 2048;
+
+  int nas = 0;
+  double vmin = R_PosInf;
+  double vmax = R_NegInf;
+  IntegerVector nequal(equal.size());
+  IntegerVector nbelow(below.size());
+  IntegerVector nover(over.size());
+  IntegerVector hist(std::max(breaks.size() - 1, 0));
+
+  for (R_xlen_t start = 0 ; start < n ; start += BLOCK)
+  {
+    const T* b = x + start;
+    R_xlen_t m = std::min(BLOCK, n - start);
+
+    for (R_xlen_t i = 0 ; i < m ; i++)
+    {
+      bool na = is_na(b[i]);
+      double v = (double)b[i];
+      nas += na;
+      vmin = (!na && v < vmin) ? v : vmin;
+      vmax = (!na && v > vmax) ? v : vmax;
+    }
+
+    for (int k = 0 ; k < equal.size() ; k++)
+      nequal[k] += count_equal(b, m, equal[k]);
+
+    for (int k = 0 ; k < below.size() ; k++)
+      nbelow[k] += count_below(b, m, below[k]);
+
+    for (int k = 0 ; k < over.size() ; k++)
+      nover[k] += count_over(b, m, over[k]);
+
+    // Same bins than findInterval(): [breaks[i], breaks[i+1][. The values out of the breaks
+    // (including the last one) are not counted.
+    if (hist.size() > 0)
+    {
+      for (R_xlen_t i = 0 ; i < m ; i++)
+      {
+        if (is_na(b[i]))
+          continue;
+
+        int bin = std::upper_bound(breaks.begin(), breaks.end(), (double)b[i]) - breaks.begin();
+
+        if (bin > 0 && bin < breaks.size())
+          hist[bin-1]++;
+      }
+    }
+  }
+
+  if (n == nas)
+  {
+    vmin = NA_REAL;
+    vmax = NA_REAL;
+  }
+
+  return List::create(Named("n") = (double)n, Named("na") = nas, Named("min") = vmin, Named("max") = vmax,
+                      Named("equal") = nequal, Named("below") = nbelow, Named("over") = nover, Named("hist") = hist);
+}
+
 // [[Rcpp::export]]
 IntegerVector fast_table(IntegerVector x, int size = 5)
 {
@@ -46,21 +150,39 @@ IntegerVector fast_table(IntegerVector x, int size = 5)
 }
 
 // [[Rcpp::export]]
-int fast_countequal(NumericVector x, double t)
+int fast_countequal(SEXP x, double t)
 {
-  return std::count(x.begin(), x.end(), t);
+  DISPATCH(x, count_equal, t)
 }
 
 // [[Rcpp::export]]
-int fast_countbelow(NumericVector x, double t)
+int fast_countbelow(SEXP x, double t)
 {
-  return std::count_if(x.begin(), x.end(), std::bind2nd(std::less<double>(), t));
+  DISPATCH(x, count_below, t)
 }
 
 // [[Rcpp::export]]
-int fast_countover(NumericVector x, double t)
+int fast_countover(SEXP x, double t)
 {
-  return std::count_if(x.begin(), x.end(), std::bind2nd(std::greater<double>(), t));
+  DISPATCH(x, count_over, t)
+}
+
+// [[Rcpp::export]]
+List fast_summary(SEXP x, NumericVector equal = NumericVector::create(), NumericVector below = NumericVector::create(), NumericVector over = NumericVector::create(), NumericVector breaks = NumericVector::create())
+{
+  // A list of vectors: one summary per vector in a single call
+  if (TYPEOF(x) == VECSXP)
+  {
+    R_xlen_t n = XLENGTH(x);
+    List summaries(n);
+
+    for (R_xlen_t i = 0 ; i < n ; i++)
+      summaries[i] = fast_summary(VECTOR_ELT(x, i), equal, below, over, breaks);
+
+    return summaries;
+  }
+
+  DISPATCH(x, column_summary, equal, below, over, breaks)
 }
 
 // [[Rcpp::export]]
@@ -77,29 +199,19 @@ NumericVector fast_extract(NumericMatrix r, NumericVector x, NumericVector y, do
     double yk = y[k];
     double xk = x[k];
 
-    if (yk < ymin || yk > ymax) {
-      z(k) = NumericVector::get_na();
-      continue;
-    }
-
-    if (xk < xmin || xk > xmax) {
+    if (yk < ymin || yk > ymax || xk < xmin || xk > xmax)
+    {
       z(k) = NumericVector::get_na();
       continue;
     }
 
-    if (yk == (int)yk)
-      yk = yk-0.01*res;
+    // Same rules than raster::extract: the first row is at the top and the points on the
+    // right and bottom edges belong to the last column and the last row.
+    int j = (int)((xk - xmin) / res);
+    int i = (int)((ymax - yk) / res);
 
-    double sx = xk - xmin;
-    double sy = yk - ymin;
-
-    int j = (int)(std::abs((sx) / res) + 1)-1;
-    int i = r.nrow() - (int)(std::abs((sy) / res))-1;
-
-    if (j == w)
-      j--;
-
-    //Rcpp::Rcout << i << " " << j << std::endl;
+    if (j >= w) j = w - 1;
+    if (i >= h) i = h - 1;
 
     z(k) = r(i, j);
   }
@@ -107,16 +219,28 @@ NumericVector fast_extract(NumericMatrix r, NumericVector x, NumericVector y, do
   return(z);
 }
 
+// Rounds to 'digit' decimal places like round() in R. With inplace = TRUE x itself is rounded
+// and returned so no new vector is allocated (x must not be shared with another object). R
+// rounds the halves to the even digit (round(2.5) is 2): with digit = 0 this is nearbyint()
+// in the default rounding mode, not round() that rounds the halves away from zero.
 // [[Rcpp::export]]
-NumericVector roundc(NumericVector x, int digit = 0)
+NumericVector roundc(NumericVector x, int digit = 0, bool inplace = false)
 {
-  NumericVector y(x.length());
-  NumericVector::iterator itx = x.begin();
-  NumericVector::iterator ity = y.begin();
+  NumericVector y = inplace ? x : NumericVector(x.length());
+  R_xlen_t n = x.length();
 
-  for(itx = x.begin(), ity = y.begin() ; itx != x.end() ; ++itx, ++ity)
+  const double* px = &x[0];
+  double* py = &y[0];
+
+  if (digit == 0)
+  {
+    for (R_xlen_t i = 0 ; i < n ; i++)
+      py[i] = nearbyint(px[i]);
+  }
+  else
   {
-    *ity = round(*itx);
+    for (R_xlen_t i = 0 ; i < n ; i++)
+      py[i] = Rf_fround(px[i], digit);
   }
 
   return y;
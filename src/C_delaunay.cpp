@@ -0,0 +1,63 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include <Rcpp.h>
+#include "Delaunay.h"
+#include "Progress.h"
+
+using namespace Rcpp;
+
+// [[Rcpp::export]]
+IntegerMatrix C_delaunay(NumericVector X, NumericVector Y, bool displaybar = false)
+{
+  if (X.size() != Y.size())
+    stop("Internal error in C_delaunay: X and Y have different sizes.");
+
+  Progress p(X.size(), displaybar);
+
+  // The constructor makes its own centered copy of the coordinates
+  Delaunay dn(X.begin(), Y.begin(), X.size());
+  dn.triangulate(p);
+
+  std::vector<int> triangles;
+  dn.get_triangles(triangles);
+
+  // One triangle per row with 1-based indices like geometry::delaunayn
+  int ntri = triangles.size()/3;
+  IntegerMatrix output(ntri, 3);
+
+  for (int i = 0 ; i < ntri ; i++)
+  {
+    output(i, 0) = triangles[3*i] + 1;
+    output(i, 1) = triangles[3*i+1] + 1;
+    output(i, 2) = triangles[3*i+2] + 1;
+  }
+
+  return output;
+}
@@ -28,22 +28,40 @@
  */
 
 #include "RasterProcessors.h"
+#include "LASView.h"
+#include "Instrumentation.h"
+
+// core = c(xmin, ymin, xmax, ymax): only the cells whose center is in this rectangle are
+// computed, typically the core of a buffered cluster of a catalog. NULL for all the cells.
+static void set_core(PointToRasterProcessor& processor, SEXP core)
+{
+  if (Rf_isNull(core))
+    return;
+
+  NumericVector bbox(core);
+  processor.set_core(bbox[0], bbox[1], bbox[2], bbox[3]);
+}
 
 // [[Rcpp::export]]
-List C_grid_canopy(S4 las, double res, double subcircle = 0)
+List C_grid_canopy(S4 las, double res, double subcircle = 0, SEXP core = R_NilValue)
 {
+  KernelScope scope("C_grid_canopy");
+
+  Stage input("input");
   S4 header = las.slot("header");
   List phb  = header.slot("PHB");
-  DataFrame data = as<Rcpp::DataFrame>(las.slot("data"));
+  LASView points(las);
 
   double xmax = phb["Max X"];
   double xmin = phb["Min X"];
   double ymax = phb["Max Y"];
   double ymin = phb["Min Y"];
 
-  NumericVector X = data["X"];
-  NumericVector Y = data["Y"];
-  NumericVector Z = data["Z"];
+  NumericVector X = points.X;
+  NumericVector Y = points.Y;
+  NumericVector Z = points.Z;
+  input.add(X.length());
+  input.stop();
 
   try
   {
@@ -53,29 +71,81 @@ List C_grid_canopy(S4 las, double res, double subcircle = 0)
                                      ymax + subcircle,
                                      res);
 
-    if (subcircle > 0)
-    {
-      double angle[8] = {0, 2*PI/8, 4*PI/8, 6*PI/8, PI, 10*PI/8, 12*PI/8, 14*PI/8};
-
-      for (int i = 0 ; i < X.length() ; i++)
-      {
-        for (int j = 0 ; j < 8 ; j++)
-        {
-          double x = X[i] + subcircle * cos(angle[j]);
-          double y = Y[i] + subcircle * sin(angle[j]);
-          processor.max(x, y, Z[i]);
-        }
-      }
-    }
-    else
+    processor.add_layer("max", "Z");
+    set_core(processor, core);
+
+    Stage stage("rasterize");
+    processor.rasterize(X, Y, Z, IntegerVector(0), subcircle);
+    stage.add(X.length());
+    stage.stop();
+
+    Stage output("output");
+    return processor.expend_layers();
+  }
+  catch (std::exception const& e)
+  {
+    stop(e.what());
+    return(List(0));
+  }
+}
+
+// Computes several statistics of the points per cell in a single pass over the point cloud.
+// Each element of 'stats' is one of "max", "min", "count", "sum", "mean", "sumsq" optionally
+// followed by "_first" to use only the first returns. The columns are named after 'names'.
+// [[Rcpp::export]]
+List C_rasterize(S4 las, double res, CharacterVector stats, CharacterVector names, double subcircle = 0, SEXP core = R_NilValue)
+{
+  if (names.length() != stats.length())
+    stop("Statistics and names have different lengths.");
+
+  KernelScope scope("C_rasterize");
+
+  Stage input("input");
+  S4 header = las.slot("header");
+  List phb  = header.slot("PHB");
+  LASView points(las);
+
+  double xmax = phb["Max X"];
+  double xmin = phb["Min X"];
+  double ymax = phb["Max Y"];
+  double ymin = phb["Min Y"];
+
+  NumericVector X = points.X;
+  NumericVector Y = points.Y;
+  NumericVector Z = points.Z;
+  input.add(X.length());
+  input.stop();
+
+  try
+  {
+    PointToRasterProcessor processor(xmin - subcircle,
+                                     ymin - subcircle,
+                                     xmax + subcircle,
+                                     ymax + subcircle,
+                                     res);
+
+    for (int i = 0 ; i < stats.length() ; i++)
+      processor.add_layer(as<std::string>(stats[i]), as<std::string>(names[i]));
+
+    set_core(processor, core);
+
+    IntegerVector ReturnNumber(0);
+
+    if (processor.need_returnnumber())
     {
-      for (int i = 0 ; i < X.length() ; i++)
-      {
-        processor.max(X[i], Y[i], Z[i]);
-      }
+      if (!points.has("ReturnNumber"))
+        throw exception("no 'ReturnNumber' field in the point cloud.");
+
+      ReturnNumber = points.column("ReturnNumber");
     }
 
-    return processor.expend();
+    Stage stage("rasterize");
+    processor.rasterize(X, Y, Z, ReturnNumber, subcircle);
+    stage.add(X.length());
+    stage.stop();
+
+    Stage output("output");
+    return processor.expend_layers();
   }
   catch (std::exception const& e)
   {
@@ -83,4 +153,3 @@ List C_grid_canopy(S4 las, double res, double subcircle = 0)
     return(List(0));
   }
 }
-
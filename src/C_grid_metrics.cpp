@@ -0,0 +1,298 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include <Rcpp.h>
+#include <algorithm>
+#include "myomp.h"
+#include "Voxelizer.h"
+#include "Instrumentation.h"
+
+using namespace Rcpp;
+
+// Built-in metrics of the fast path of grid_metrics. See fast_metrics_call() on the R side.
+enum FastMetric {MAX = 0, MIN, SUM, MEAN, SD, VAR, COUNT, QUANTILE, PABOVE, COUNTEQUAL};
+
+// mean() as computed by R: long double accumulation and a second pass to correct the rounding
+static double rmean(const double* x, int n)
+{
+  long double s = 0;
+  for (int i = 0 ; i < n ; i++) s += x[i];
+  s /= n;
+
+  if (std::isfinite((double)s))
+  {
+    long double t = 0;
+    for (int i = 0 ; i < n ; i++) t += (x[i] - s);
+    s += t/n;
+  }
+
+  return (double)s;
+}
+
+static double rvar(const double* x, int n)
+{
+  if (n < 2)
+    return NA_REAL;
+
+  long double m = rmean(x, n);
+  long double s = 0;
+
+  for (int i = 0 ; i < n ; i++)
+    s += (x[i] - m) * (x[i] - m);
+
+  return (double)(s/(n-1));
+}
+
+// quantile() type 7 as computed by R. Reorders x.
+static double rquantile(double* x, int n, double p)
+{
+  double index = 1 + (n - 1) * p;
+  int lo = std::floor(index);
+  int hi = std::ceil(index);
+
+  std::nth_element(x, x + lo - 1, x + n);
+  double qs = x[lo-1];
+
+  if (index > lo && hi <= n)
+  {
+    double xhi = *std::min_element(x + lo, x + n);
+
+    if (xhi != qs)
+    {
+      double h = index - lo;
+      qs = (1 - h) * qs + h * xhi;
+    }
+  }
+
+  return qs;
+}
+
+// Computes the metrics in each voxel. 'values' are the attributes used by the metrics,
+// 'variable' is the index in 'values' used by each metric and 'param' its parameter
+// (probability, threshold).
+static List voxel_metrics(const Voxelizer& vox, bool is3d, List values, IntegerVector metric, IntegerVector variable, NumericVector param, CharacterVector names, int ncpu)
+{
+  int nmetrics = metric.length();
+  int nvalues = values.length();
+  int ncells = vox.nvoxels;
+  const std::vector<int>& offset = vox.offset;
+  const std::vector<int>& index = vox.index;
+
+  Stage gather("gather");
+  std::vector< std::vector<double> > slices(nvalues);
+
+  for (int v = 0 ; v < nvalues ; v++)
+  {
+    NumericVector val = values[v];
+    slices[v].resize(index.size());
+
+    for (unsigned int j = 0 ; j < index.size() ; j++)
+      slices[v][j] = val[index[j]];
+  }
+
+  gather.add((double)nvalues * index.size());
+  gather.stop();
+
+  // Output
+  int ncoords = is3d ? 3 : 2;
+  NumericVector Xgrid(ncells), Ygrid(ncells), Zgrid(is3d ? ncells : 0);
+  std::vector< std::vector<double> > out(nmetrics, std::vector<double>(ncells));
+
+  for (int c = 0 ; c < ncells ; c++)
+  {
+    Xgrid[c] = vox.x(c);
+    Ygrid[c] = vox.y(c);
+    if (is3d) Zgrid[c] = vox.z(c);
+  }
+
+  Stage stage("metrics");
+
+  #pragma omp parallel num_threads(ncpu)
+  {
+    std::vector<double> buffer;
+
+    #pragma omp for
+    for (int c = 0 ; c < ncells ; c++)
+    {
+      int m = offset[c+1] - offset[c];
+
+      // Order dependent metrics first, the quantiles reorder a copy of the values
+      for (int k = 0 ; k < nmetrics ; k++)
+      {
+        if (metric[k] == QUANTILE)
+          continue;
+
+        const double* x = &slices[variable[k]][offset[c]];
+        double value = 0;
+
+        switch (metric[k])
+        {
+          case MAX: value = *std::max_element(x, x + m); break;
+          case MIN: value = *std::min_element(x, x + m); break;
+          case SUM:
+          {
+            long double s = 0;
+            for (int i = 0 ; i < m ; i++) s += x[i];
+            value = (double)s;
+            break;
+          }
+          case MEAN: value = rmean(x, m); break;
+          case SD: value = std::sqrt(rvar(x, m)); break;
+          case VAR: value = rvar(x, m); break;
+          case COUNT: value = m; break;
+          case PABOVE:
+          {
+            int s = 0;
+            for (int i = 0 ; i < m ; i++) s += x[i] > param[k];
+            value = (double)s/m*100;
+            break;
+          }
+          case COUNTEQUAL:
+          {
+            int s = 0;
+            for (int i = 0 ; i < m ; i++) s += x[i] == param[k];
+            value = s;
+            break;
+          }
+        }
+
+        out[k][c] = value;
+      }
+
+      for (int k = 0 ; k < nmetrics ; k++)
+      {
+        if (metric[k] != QUANTILE)
+          continue;
+
+        const double* x = &slices[variable[k]][offset[c]];
+        buffer.assign(x, x + m);
+        out[k][c] = rquantile(&buffer[0], m, param[k]);
+      }
+    }
+  }
+
+  stage.add(ncells, index.size());
+  stage.stop();
+
+  Stage output("output");
+  List ret(nmetrics + ncoords);
+  CharacterVector retnames(nmetrics + ncoords);
+  ret[0] = Xgrid;
+  ret[1] = Ygrid;
+  retnames[0] = "X";
+  retnames[1] = "Y";
+
+  if (is3d)
+  {
+    ret[2] = Zgrid;
+    retnames[2] = "Z";
+  }
+
+  for (int k = 0 ; k < nmetrics ; k++)
+  {
+    if (metric[k] == COUNT || metric[k] == COUNTEQUAL)
+    {
+      IntegerVector v(ncells);
+      std::copy(out[k].begin(), out[k].end(), v.begin());
+      ret[k+ncoords] = v;
+    }
+    else
+    {
+      ret[k+ncoords] = wrap(out[k]);
+    }
+
+    retnames[k+ncoords] = names[k];
+  }
+
+  ret.attr("names") = retnames;
+  output.add(ncells);
+  return ret;
+}
+
+// Computes a fixed set of metrics in each cell of the same grid than grid_metrics. The
+// points are binned once, bucketed by cell to get a contiguous slice of values per cell and
+// the metrics are computed in C++. The cells are returned in order of first appearance like
+// a data.table grouping. If core = c(xmin, ymin, xmax, ymax) is given only the cells whose
+// center is in this rectangle are computed.
+// [[Rcpp::export]]
+List C_grid_metrics(NumericVector X, NumericVector Y, List values, IntegerVector metric, IntegerVector variable, NumericVector param, CharacterVector names, double res, NumericVector start, int ncpu = 1, SEXP core = R_NilValue)
+{
+  KernelScope scope("C_grid_metrics");
+
+  NumericVector bbox;
+  if (!Rf_isNull(core)) bbox = NumericVector(core);
+
+  Stage stage("binning");
+  Voxelizer vox(&X[0], &Y[0], 0, X.length(), res, &start[0], Rf_isNull(core) ? 0 : &bbox[0]);
+  stage.add(X.length());
+  stage.stop();
+
+  return voxel_metrics(vox, false, values, metric, variable, param, names, ncpu);
+}
+
+// Same as C_grid_metrics in the voxels of grid_metrics3d
+// [[Rcpp::export]]
+List C_voxel_metrics(NumericVector X, NumericVector Y, NumericVector Z, List values, IntegerVector metric, IntegerVector variable, NumericVector param, CharacterVector names, double res, NumericVector start, int ncpu = 1)
+{
+  KernelScope scope("C_voxel_metrics");
+
+  Stage stage("binning");
+  Voxelizer vox(&X[0], &Y[0], &Z[0], X.length(), res, &start[0]);
+  stage.add(X.length());
+  stage.stop();
+
+  return voxel_metrics(vox, true, values, metric, variable, param, names, ncpu);
+}
+
+// Sparse voxelization of a point cloud: the coordinates and the number of points of each non
+// empty voxel in order of first appearance, and the (1-based) voxel of each point
+// [[Rcpp::export]]
+List C_voxelize(NumericVector X, NumericVector Y, NumericVector Z, double res, NumericVector start)
+{
+  int n = X.length();
+  Voxelizer vox(&X[0], &Y[0], &Z[0], n, res, &start[0]);
+
+  int nvox = vox.nvoxels;
+  NumericVector Xvox(nvox), Yvox(nvox), Zvox(nvox);
+  IntegerVector count(nvox);
+  IntegerVector voxel(n, NA_INTEGER);
+
+  for (int v = 0 ; v < nvox ; v++)
+  {
+    Xvox[v] = vox.x(v);
+    Yvox[v] = vox.y(v);
+    Zvox[v] = vox.z(v);
+    count[v] = vox.offset[v+1] - vox.offset[v];
+
+    for (int k = vox.offset[v] ; k < vox.offset[v+1] ; k++)
+      voxel[vox.index[k]] = v + 1;
+  }
+
+  return List::create(Named("X") = Xvox, Named("Y") = Yvox, Named("Z") = Zvox, Named("n") = count, Named("voxel") = voxel);
+}
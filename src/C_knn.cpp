@@ -28,92 +28,331 @@
  */
 
 #include <Rcpp.h>
+#include <algorithm>
 #include "QuadTree.h"
+#include "SpatialIndex.h"
 #include "Progress.h"
+#include "Instrumentation.h"
+#include "LASView.h"
+#include "myomp.h"
 
 using namespace Rcpp;
 
 // [[Rcpp::export]]
-Rcpp::List C_knn(NumericVector X, NumericVector Y, NumericVector x, NumericVector y, int k)
+Rcpp::List C_knn(NumericVector X, NumericVector Y, NumericVector x, NumericVector y, int k, int ncpu = 1, SEXP index = R_NilValue)
 {
-  unsigned int n = x.length();
+  KernelScope scope("C_knn");
+
+  int n = x.length();
   IntegerMatrix knn_idx(n, k);
   NumericMatrix knn_dist(n, k);
 
-  QuadTree *tree = QuadTreeCreate(X,Y);
+  IndexedPoints indexed(index, X, Y);
+  QuadTree *tree = indexed.tree;
+
+  Stage stage("queries");
+  double scanned = 0;
 
-  for(unsigned int i = 0 ; i < n ; i++)
+  #pragma omp parallel for num_threads(ncpu) reduction(+:scanned)
+  for(int i = 0 ; i < n ; i++)
   {
-    std::vector<Point*> pts;
-    tree->knn_lookup(x[i], y[i], k, pts);
+    std::vector<Point> pts;
+    scanned += tree->knn_lookup(x[i], y[i], k, pts);
 
     for (unsigned int j = 0 ; j < pts.size() ; j++)
     {
-      knn_idx(i, j)  = pts[j]->id + 1;
+      knn_idx(i, j)  = pts[j].id + 1;
 
-      double dx = pts[j]->x - x[i];
-      double dy = pts[j]->y - y[i];
+      double dx = pts[j].x - x[i];
+      double dy = pts[j].y - y[i];
 
       knn_dist(i, j) =  std::sqrt(dx*dx + dy*dy);
     }
   }
 
-  delete tree;
+  stage.add(n, scanned);
+  stage.stop();
 
   return Rcpp::List::create(Rcpp::Named("nn.idx") = knn_idx, Rcpp::Named("nn.dist") = knn_dist);
 }
 
-// [[Rcpp::export]]
-NumericVector C_knnidw(NumericVector X, NumericVector Y, NumericVector Z, NumericVector x, NumericVector y, int k, double p)
+// Neighbour of a query point. Neighbours are ordered by distance then by ID so the k nearest
+// neighbours of a query are always the same whatever the way they were searched.
+struct Neighbour
 {
-  unsigned int n = x.length();
-  NumericVector iZ(n);
+  Neighbour() : d2(0) {}
+  Neighbour(double _d2, const Point& _p) : d2(_d2), p(_p) {}
+  bool operator<(const Neighbour& other) const { return d2 < other.d2 || (d2 == other.d2 && p.id < other.p.id); }
+  double d2;
+  Point p;
+};
 
-  QuadTree *tree = QuadTreeCreate(X,Y);
+// Visitor that collects the points closer than sqrt(r2) to (x,y)
+struct NeighbourCollector
+{
+  NeighbourCollector(double _x, double _y, double _r2, std::vector<Neighbour>& _res) : x(_x), y(_y), r2(_r2), res(_res) {}
+  void operator()(Point& p)
+  {
+    double dx = p.x - x;
+    double dy = p.y - y;
+    double d2 = dx*dx + dy*dy;
+    if (d2 <= r2) res.push_back(Neighbour(d2, p));
+  }
+  double x, y, r2;
+  std::vector<Neighbour>& res;
+};
 
-  Progress pbar(n, false);
+// Order of the queries along a Morton curve on a grid of about 4 queries per cell (counting
+// sort). Consecutive queries are thus close to each other whatever the input order.
+static std::vector<int> morton_order(const NumericVector& x, const NumericVector& y)
+{
+  int n = x.length();
+  std::vector<int> order(n);
+
+  if (n == 0)
+    return order;
 
-  for(unsigned int i = 0 ; i < n ; i++)
+  double xmin = x[0], xmax = x[0], ymin = y[0], ymax = y[0];
+
+  for (int i = 1 ; i < n ; i++)
   {
-    std::vector<Point*> pts;
-    tree->knn_lookup(x[i], y[i], k, pts);
+    if (x[i] < xmin) xmin = x[i];
+    if (x[i] > xmax) xmax = x[i];
+    if (y[i] < ymin) ymin = y[i];
+    if (y[i] > ymax) ymax = y[i];
+  }
 
-    double sum_zw = 0;
-    double sum_w  = 0;
+  int bits = 0;
+  while (bits < 10 && 4.0 * (1 << bits) * (1 << bits) < n) bits++;
 
-    for (unsigned int j = 0 ; j < pts.size() ; j++)
+  int g = 1 << bits;
+  double sx = (xmax > xmin) ? g / (xmax - xmin) : 0;
+  double sy = (ymax > ymin) ? g / (ymax - ymin) : 0;
+
+  std::vector<int> code(n);
+  std::vector<int> offset(g*g + 1, 0);
+
+  for (int i = 0 ; i < n ; i++)
+  {
+    int c = std::min(std::max((int)((x[i] - xmin) * sx), 0), g - 1);
+    int r = std::min(std::max((int)((y[i] - ymin) * sy), 0), g - 1);
+
+    int m = 0;
+    for (int b = 0 ; b < bits ; b++)
+      m |= (((c >> b) & 1) << (2*b)) | (((r >> b) & 1) << (2*b+1));
+
+    code[i] = m;
+    offset[m+1]++;
+  }
+
+  for (int m = 0 ; m < g*g ; m++)
+    offset[m+1] += offset[m];
+
+  for (int i = 0 ; i < n ; i++)
+    order[offset[code[i]]++] = i;
+
+  return order;
+}
+
+// The queries are visited in Morton order. Any k points give an upper bound of the distance to
+// the k-th neighbour, so the candidates found for the previous query are used to bound the
+// search of the current query: the neighbours are found with a single circle lookup instead
+// of a full kNN search. If the previous query is farther than twice the distance to its own
+// k-th neighbour (jumps of the curve) the bound is given by a regular kNN lookup. The k
+// neighbours are then selected in the order defined by Neighbour: the output does not depend
+// on the order of the queries, thus on the number of threads. Z is any vector like object
+// indexed by the IDs of the points of the tree.
+template<typename Values> static NumericVector knnidw(QuadTree* tree, const Values& Z, NumericVector x, NumericVector y, int k, double p, int ncpu)
+{
+  int n = x.length();
+  NumericVector iZ(n);
+
+  Progress pbar(n, false);
+
+  Stage ordering("query ordering");
+  std::vector<int> order = morton_order(x, y);
+  ordering.add(n);
+  ordering.stop();
+
+  Stage stage("queries");
+  double scanned = 0;
+
+  #pragma omp parallel num_threads(ncpu) reduction(+:scanned)
+  {
+    std::vector<Point> pts;
+    std::vector<Neighbour> candidates;
+    std::vector<Neighbour> neighbours;
+    double qx = 0, qy = 0, qr2 = -1;
+
+    #pragma omp for schedule(static)
+    for(int o = 0 ; o < n ; o++)
     {
-      double dx = pts[j]->x - x[i];
-      double dy = pts[j]->y - y[i];
-      double d  = std::sqrt(dx*dx + dy*dy);
-      double w;
-      double z = Z[pts[j]->id];
+      if (pbar.check_abort())
+        continue;
+
+      int i = order[o];
+      double px = x[i];
+      double py = y[i];
 
-      if (d > 0)
+      // Upper bound of the squared distance to the k-th neighbour
+      double r2 = -1;
+      double dqx = px - qx;
+      double dqy = py - qy;
+
+      if (!candidates.empty() && dqx*dqx + dqy*dqy <= 4*qr2)
       {
-        w = 1/pow(d,p);
-        sum_zw += z*w;
-        sum_w  += w;
+        neighbours.clear();
+
+        for (unsigned int j = 0 ; j < candidates.size() ; j++)
+        {
+          double dx = candidates[j].p.x - px;
+          double dy = candidates[j].p.y - py;
+          neighbours.push_back(Neighbour(dx*dx + dy*dy, candidates[j].p));
+        }
+
+        size_t m = std::min((size_t)k, neighbours.size()) - 1;
+        std::nth_element(neighbours.begin(), neighbours.begin() + m, neighbours.end());
+        r2 = neighbours[m].d2;
+
+        // Fewer than k candidates: all of them are needed
+        if ((int)neighbours.size() < k)
+          r2 = std::max_element(neighbours.begin(), neighbours.end())->d2;
       }
       else
       {
-        sum_zw = z;
+        pts.clear();
+        scanned += tree->knn_lookup(px, py, k, pts);
+
+        for (unsigned int j = 0 ; j < pts.size() ; j++)
+        {
+          double dx = pts[j].x - px;
+          double dy = pts[j].y - py;
+          r2 = std::max(r2, dx*dx + dy*dy);
+        }
+      }
+
+      candidates.clear();
+
+      if (r2 >= 0)
+      {
+        NeighbourCollector collector(px, py, r2, candidates);
+        scanned += tree->circle_visit(px, py, std::sqrt(r2), collector);
+      }
+
+      neighbours.assign(candidates.begin(), candidates.end());
+
+      if ((int)neighbours.size() > k)
+      {
+        std::nth_element(neighbours.begin(), neighbours.begin() + (k-1), neighbours.end());
+        neighbours.resize(k);
+      }
+
+      std::sort(neighbours.begin(), neighbours.end());
+
+      double sum_zw = 0;
+      double sum_w  = 0;
+
+      if (k == 1 && !neighbours.empty())
+      {
+        // Nearest neighbour: no weight needed
+        sum_zw = Z[neighbours[0].p.id];
         sum_w  = 1;
-        break;
       }
-    }
+      else
+      {
+        for (unsigned int j = 0 ; j < neighbours.size() ; j++)
+        {
+          double d2 = neighbours[j].d2;
+          double z  = Z[neighbours[j].p.id];
+          double w;
 
-    iZ(i) = sum_zw/sum_w;
+          if (d2 > 0)
+          {
+            if (p == 2)
+              w = 1/d2;
+            else if (p == 1)
+              w = 1/std::sqrt(d2);
+            else
+              w = 1/pow(std::sqrt(d2),p);
 
-    if (pbar.check_abort())
-    {
-      delete tree;
-      pbar.exit();
+            sum_zw += z*w;
+            sum_w  += w;
+          }
+          else
+          {
+            sum_zw = z;
+            sum_w  = 1;
+            break;
+          }
+        }
+      }
+
+      iZ(i) = sum_zw/sum_w;
+
+      qx = px;
+      qy = py;
+      qr2 = neighbours.empty() ? -1 : neighbours.back().d2;
+
+      pbar.increment();
     }
+  }
+
+  stage.add(n, scanned);
+  stage.stop();
 
-    pbar.update(i);
+  if (pbar.check_abort())
+    pbar.exit();
+
+  return iZ;
+}
+
+// [[Rcpp::export]]
+NumericVector C_knnidw(NumericVector X, NumericVector Y, NumericVector Z, NumericVector x, NumericVector y, int k, double p, int ncpu = 1, SEXP index = R_NilValue)
+{
+  KernelScope scope("C_knnidw");
+
+  IndexedPoints indexed(index, X, Y);
+  return knnidw(indexed.tree, Z, x, y, k, p, ncpu);
+}
+
+// Same as C_knnidw with, as reference points, the points of the LAS object of class
+// 'classification' (typically the ground points). The subset is a view on the columns of
+// the point cloud (no copy) and the degenerated points are removed with the rules of the R
+// function interpolate(). The numbers of points removed are returned in the attribute
+// "duplicates" (same X Y Z, same X Y) so the R side can report them.
+// [[Rcpp::export]]
+NumericVector C_knnidw_las(S4 las, NumericVector x, NumericVector y, int k, double p, int classification = 2, int ncpu = 1)
+{
+  KernelScope scope("C_knnidw_las");
+
+  Stage selection("selection");
+  LASView points(las);
+  points.select("Classification", classification);
+
+  int ndup_xyz, ndup_xy;
+  points.unique_xy(ndup_xyz, ndup_xy);
+  selection.add(points.size());
+  selection.stop();
+
+  Stage build("index build");
+  QuadTree* tree = QuadTreeCreate(points.x(), points.y());
+  build.add(points.size());
+  build.stop();
+
+  NumericVector iZ;
+
+  try
+  {
+    iZ = knnidw(tree, points.z(), x, y, k, p, ncpu);
+  }
+  catch (...)
+  {
+    delete tree;
+    throw;
   }
 
   delete tree;
+
+  iZ.attr("duplicates") = IntegerVector::create(ndup_xyz, ndup_xy);
   return iZ;
 }
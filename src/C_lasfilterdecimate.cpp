@@ -0,0 +1,216 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+
+#include <Rcpp.h>
+#include <algorithm>
+#include <cmath>
+#include "myomp.h"
+#include "Voxelizer.h"
+
+using namespace Rcpp;
+
+// xorshift32 seeded for each cell, so the selection does not depend on the number of threads
+struct CellRandom
+{
+  CellRandom(unsigned int seed, unsigned int cell)
+  {
+    state = seed ^ ((cell + 1) * 2654435761u);
+    if (state == 0) state = 2463534242u;
+    for (int i = 0 ; i < 4 ; i++) next();
+  }
+
+  unsigned int next()
+  {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  double unif() { return next() * 2.3283064365386963e-10; }
+
+  unsigned int state;
+};
+
+// Selection sampling (Knuth's algorithm S): flags k of the m elements of x uniformly, in order
+template<typename T> static void select_k(const T* x, int m, int k, CellRandom& random, char* keep)
+{
+  for (int i = 0 ; i < m && k > 0 ; i++)
+  {
+    if ((m - i) * random.unif() < k)
+    {
+      keep[x[i]] = 1;
+      k--;
+    }
+  }
+}
+
+// 1-based indices of the flagged points
+static IntegerVector selected_index(const std::vector<char>& keep)
+{
+  int n = 0;
+  for (unsigned int i = 0 ; i < keep.size() ; i++) n += keep[i];
+
+  IntegerVector out(n);
+  for (unsigned int i = 0, j = 0 ; i < keep.size() ; i++)
+    if (keep[i]) out[j++] = i + 1;
+
+  return out;
+}
+
+// Homogeneous decimation: in each cell of the same grid than group_grid() keeps n random points
+// or all the points of n random pulses, or all the points of the cell if there are not enough.
+// The cells are computed natively in a single pass. Returns the (1-based) indices of the
+// selected points in their original order.
+// [[Rcpp::export]]
+IntegerVector C_lasfilterdecimate(NumericVector X, NumericVector Y, double res, int n, NumericVector pulse, bool use_pulse, unsigned int seed, bool homogenize = true, int ncpu = 1)
+{
+  int npoints = X.length();
+  double start[2] = {0, 0};
+  std::vector<int> offset;
+  std::vector<int> index;
+
+  if (homogenize)
+  {
+    Voxelizer vox(&X[0], &Y[0], 0, npoints, res, start);
+    offset.swap(vox.offset);
+    index.swap(vox.index);
+  }
+  else
+  {
+    // The whole point cloud is a single cell
+    offset.push_back(0);
+    offset.push_back(npoints);
+    index.resize(npoints);
+    for (int i = 0 ; i < npoints ; i++) index[i] = i;
+  }
+
+  int ncells = offset.size() - 1;
+  std::vector<char> keep(npoints, 0);
+
+  #pragma omp parallel num_threads(ncpu)
+  {
+    std::vector<double> pulses;
+    std::vector<char> selected;
+    std::vector<int> position;
+
+    #pragma omp for
+    for (int c = 0 ; c < ncells ; c++)
+    {
+      const int* idx = &index[0] + offset[c];
+      int m = offset[c+1] - offset[c];
+      CellRandom random(seed, c);
+
+      if (!use_pulse)
+      {
+        if (n >= m)
+          for (int i = 0 ; i < m ; i++) keep[idx[i]] = 1;
+        else
+          select_k(idx, m, n, random, &keep[0]);
+
+        continue;
+      }
+
+      // The NA pulseIDs cannot be sorted. Like unique() in R they make a single pulse, which
+      // is given the last position.
+      bool has_na = false;
+      pulses.clear();
+
+      for (int i = 0 ; i < m ; i++)
+      {
+        double id = pulse[idx[i]];
+
+        if (std::isnan(id))
+          has_na = true;
+        else
+          pulses.push_back(id);
+      }
+
+      std::sort(pulses.begin(), pulses.end());
+      pulses.erase(std::unique(pulses.begin(), pulses.end()), pulses.end());
+
+      int nvalid = pulses.size();
+      int p = nvalid + has_na;
+
+      if (n >= p)
+      {
+        for (int i = 0 ; i < m ; i++) keep[idx[i]] = 1;
+        continue;
+      }
+
+      position.resize(p);
+      selected.assign(p, 0);
+      for (int i = 0 ; i < p ; i++) position[i] = i;
+      select_k(&position[0], p, n, random, &selected[0]);
+
+      for (int i = 0 ; i < m ; i++)
+      {
+        double id = pulse[idx[i]];
+        int j = std::isnan(id) ? nvalid : std::lower_bound(pulses.begin(), pulses.end(), id) - pulses.begin();
+        if (selected[j]) keep[idx[i]] = 1;
+      }
+    }
+  }
+
+  return selected_index(keep);
+}
+
+// Keeps the highest point of each cell of the same grid than group_grid(). Returns the (1-based)
+// indices of the selected points in their original order.
+// [[Rcpp::export]]
+IntegerVector C_lasfiltersurfacepoints(NumericVector X, NumericVector Y, NumericVector Z, double res, int ncpu = 1)
+{
+  int npoints = X.length();
+  double start[2] = {0, 0};
+  Voxelizer vox(&X[0], &Y[0], 0, npoints, res, start);
+
+  int ncells = vox.nvoxels;
+  std::vector<char> keep(npoints, 0);
+
+  #pragma omp parallel for num_threads(ncpu)
+  for (int c = 0 ; c < ncells ; c++)
+  {
+    int highest = -1;
+
+    // First maximum like which.max(), NAs ignored
+    for (int k = vox.offset[c] ; k < vox.offset[c+1] ; k++)
+    {
+      int i = vox.index[k];
+
+      if (!std::isnan(Z[i]) && (highest < 0 || Z[i] > Z[highest]))
+        highest = i;
+    }
+
+    if (highest >= 0)
+      keep[highest] = 1;
+  }
+
+  return selected_index(keep);
+}
@@ -0,0 +1,116 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include <Rcpp.h>
+#include "myomp.h"
+#include <cmath>
+
+using namespace Rcpp;
+
+// Normalizes the elevations with a DTM in a single pass: the elevation of the ground is read
+// in the DTM, subtracted from Z and rounded. The DTM is the matrix of a RasterLayer (first
+// row at the top) and the lookup follows the same rules than raster::extract. The points out
+// of the DTM or on NA cells get NA.
+// [[Rcpp::export]]
+NumericVector C_lasnormalize(NumericVector X, NumericVector Y, NumericVector Z, NumericMatrix dtm, double xmin, double ymax, double xres, double yres, bool bilinear = false, int digits = 3, int ncpu = 1)
+{
+  int n = X.size();
+  int nrows = dtm.nrow();
+  int ncols = dtm.ncol();
+  double xmax = xmin + ncols * xres;
+  double ymin = ymax - nrows * yres;
+
+  const double* x = &X[0];
+  const double* y = &Y[0];
+  const double* z = &Z[0];
+  const double* r = &dtm[0];
+
+  NumericVector out(n);
+  double* o = &out[0];
+
+  #pragma omp parallel for num_threads(ncpu)
+  for (int k = 0 ; k < n ; k++)
+  {
+    double xk = x[k];
+    double yk = y[k];
+
+    if (xk < xmin || xk > xmax || yk < ymin || yk > ymax)
+    {
+      o[k] = NA_REAL;
+      continue;
+    }
+
+    double zg;
+
+    if (!bilinear)
+    {
+      // Cell containing the point. The points on the right and bottom edges belong to the
+      // last column and the last row.
+      int j = (int)((xk - xmin) / xres);
+      int i = (int)((ymax - yk) / yres);
+      if (j >= ncols) j = ncols - 1;
+      if (i >= nrows) i = nrows - 1;
+
+      zg = r[i + (size_t)j * nrows];
+    }
+    else
+    {
+      // Position relative to the centers of the cells, clamped on the half cells at the edges
+      double fx = (xk - xmin) / xres - 0.5;
+      double fy = (ymax - yk) / yres - 0.5;
+      fx = std::min(std::max(fx, 0.0), (double)(ncols - 1));
+      fy = std::min(std::max(fy, 0.0), (double)(nrows - 1));
+
+      int j0 = (int)fx;
+      int i0 = (int)fy;
+      int j1 = std::min(j0 + 1, ncols - 1);
+      int i1 = std::min(i0 + 1, nrows - 1);
+      double tx = fx - j0;
+      double ty = fy - i0;
+
+      double z00 = r[i0 + (size_t)j0 * nrows];
+      double z01 = r[i0 + (size_t)j1 * nrows];
+      double z10 = r[i1 + (size_t)j0 * nrows];
+      double z11 = r[i1 + (size_t)j1 * nrows];
+
+      zg = (1 - ty) * ((1 - tx) * z00 + tx * z01) + ty * ((1 - tx) * z10 + tx * z11);
+    }
+
+    if (std::isnan(zg))
+    {
+      o[k] = NA_REAL;
+      continue;
+    }
+
+    // Same rounding than round() in R
+    o[k] = Rf_fround(z[k] - zg, digits);
+  }
+
+  return out;
+}
@@ -30,74 +30,94 @@
 #include <Rcpp.h>
 #include <limits>
 #include "QuadTree.h"
+#include "SpatialIndex.h"
 #include "Progress.h"
+#include "Instrumentation.h"
+#include "myomp.h"
+#include "OutputVector.h"
 
 using namespace Rcpp;
 
+// QuadTree visitor that accumulates the (weighted) sum of Z of the points of a neighbourhood
+struct SmoothAccumulator
+{
+  SmoothAccumulator(NumericVector& _Z, double _x, double _y, int _method, double _twosquaresigma) :
+    Z(_Z), x(_x), y(_y), method(_method), twosquaresigma(_twosquaresigma), ztot(0), wtot(0) {}
+
+  void operator()(const Point& p)
+  {
+    double w;
+
+    if (method == 1)
+    {
+      w = 1;
+    }
+    else
+    {
+      double dx =  x - p.x;
+      double dy =  y - p.y;
+      w = 1/(twosquaresigma * PI) * std::exp(-(dx*dx + dy*dy)/twosquaresigma);
+    }
+
+    ztot += w*Z[p.id];
+    wtot += w;
+  }
+
+  NumericVector& Z;
+  double x, y;
+  int method;
+  double twosquaresigma;
+  double ztot, wtot;
+};
+
 // [[Rcpp::export]]
-NumericVector C_lassmooth(S4 las, double size, int method = 1, int shape = 1, double sigma = 1)
+NumericVector C_lassmooth(NumericVector X, NumericVector Y, NumericVector Z, double size, int method = 1, int shape = 1, double sigma = 1, int ncpu = 1, SEXP output = R_NilValue, SEXP index = R_NilValue)
 {
   // shape: 1- rectangle 2- circle
   // method: 1- average 2- gaussian
-  DataFrame data = as<Rcpp::DataFrame>(las.slot("data"));
+  KernelScope scope("C_lassmooth");
 
-  NumericVector X = data["X"];
-  NumericVector Y = data["Y"];
-  NumericVector Z = data["Z"];
-
-  unsigned int n = X.length();
+  int n = X.length();
   double half_res = size / 2;
   double twosquaresigma = 2*sigma*sigma;
-  double twosquaresigmapi = twosquaresigma * PI;
 
-  NumericVector Z_temp;
-  NumericVector Z_out  = clone(Z);
+  // The neighbourhoods are read in Z while the output is written: they cannot be the same vector
+  NumericVector Z_out = output_vector<REALSXP>(output, n);
+
+  if (n > 0 && &Z_out[0] == &Z[0])
+    stop("Internal error in C_lassmooth: the output vector cannot be Z.");
 
-  QuadTree *tree = QuadTreeCreate(X,Y);
+  IndexedPoints indexed(index, X, Y);
+  QuadTree *tree = indexed.tree;
 
   Progress p(n, false);
 
-  for (unsigned int i = 0 ; i < n ; i++)
+  Stage stage("queries");
+  double scanned = 0;
+
+  #pragma omp parallel for num_threads(ncpu) reduction(+:scanned)
+  for (int i = 0 ; i < n ; i++)
   {
-    std::vector<Point*> pts;
+    if (p.check_abort())
+      continue;
+
+    SmoothAccumulator acc(Z, X[i], Y[i], method, twosquaresigma);
 
     if(shape == 1)
-      tree->rect_lookup(X[i], Y[i], half_res, half_res, pts);
+      scanned += tree->rect_visit(X[i], Y[i], half_res, half_res, acc);
     else
-      tree->circle_lookup(X[i], Y[i], half_res, pts);
+      scanned += tree->circle_visit(X[i], Y[i], half_res, acc);
 
-    double w = 0;
-    double ztot = 0;
-    double wtot = 0;
+    Z_out[i] = acc.ztot/acc.wtot;
 
-    for(unsigned int j = 0 ; j < pts.size() ; j++)
-    {
-      if (method == 1)
-      {
-        w = 1;
-      }
-      else
-      {
-        double dx =  X[i] - pts[j]->x;
-        double dy =  Y[i] - pts[j]->y;
-        w = 1/twosquaresigmapi * std::exp(-(dx*dx + dy*dy)/twosquaresigma);
-      }
-
-      ztot += w*Z[pts[j]->id];
-      wtot += w;
-    }
-
-    Z_out[i] = ztot/wtot;
+    p.increment();
+  }
 
-    if (p.check_abort())
-    {
-      delete tree;
-      p.exit();
-    }
+  stage.add(n, scanned);
+  stage.stop();
 
-    p.update(i);
-  }
+  if (p.check_abort())
+    p.exit();
 
-  delete tree;
   return Z_out;
 }
\ No newline at end of file
@@ -29,28 +29,34 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 
 #include <Rcpp.h>
 #include <algorithm>
+#include <map>
 #include "Point.h"
 using namespace Rcpp;
 
+// Seeded region growing (Dalponte and Coomes 2016). The growing is driven by a frontier of
+// labelled pixels that may still have a neighbour to add, so only those pixels are visited at
+// each iteration instead of the whole image. A pixel leaves the frontier as soon as none of its
+// neighbours can ever join its crown. Within an iteration the frontier is visited in the same
+// order than a raster scan and the labels are updated at the end of the iteration, so the
+// output is exactly the same than with repeated full scans. Crown statistics are stored in
+// dense vectors indexed by seed.
 //[[Rcpp::export]]
 IntegerMatrix C_lastrees_dalponte(NumericMatrix Image, IntegerMatrix Seeds, double th_seed, double th_crown, double th_tree, double DIST)
 {
-  bool grown = true;
-  bool expend;
   int nrow  = Image.nrow();
   int ncol  = Image.ncol();
 
   if (Seeds.nrow() != nrow || Seeds.ncol() != ncol)
     throw std::runtime_error(std::string("Error: unexpected internal error: different matrix sizes."));
 
-  std::vector< Pixel<double> > neighbours(4);
+  std::map<int, int> ids;                                               // Seed ID to dense index (initialisation only)
+  std::vector< Pixel<int> > seeds;                                      // Stores all the seed as Pixel object
+  std::vector<double> sum_height;                                       // Stores the sum of the elevation of each pixel of a tree (to compute mean height)
+  std::vector<int> npixel;
 
-  IntegerMatrix Region     = clone(Seeds);
-  IntegerMatrix Regiontemp = clone(Seeds);
-
-  std::map<int, Pixel<int> > seeds;                                     // Stores all the seed as Pixel object
-  std::map<int, double> sum_height;                                     // Stores the sum of the elevation of each pixel of a tree (to compute mean height)
-  std::map<int, int> npixel;
+  std::vector<int> label(nrow*ncol, -1);                                // Dense index of the crown of each pixel in raster order
+  std::vector<int> labeltemp(nrow*ncol, -1);                            // Labels assigned during the current iteration
+  std::vector<int> frontier, next, added;
 
   for (int i = 0 ; i < nrow ; i++)
   {
@@ -58,63 +64,125 @@ IntegerMatrix C_lastrees_dalponte(NumericMatrix Image, IntegerMatrix Seeds, doub
     {
       if (Seeds(i,j) != 0)
       {
-        seeds[Seeds(i,j)] = Pixel<int>(i,j, Seeds(i,j));
-        sum_height[Seeds(i,j)] = Image(i,j);
-        npixel[Seeds(i,j)] = 1;
+        std::map<int, int>::iterator it = ids.find(Seeds(i,j));
+        int id;
+
+        if (it == ids.end())
+        {
+          id = seeds.size();
+          ids[Seeds(i,j)] = id;
+          seeds.push_back(Pixel<int>());
+          sum_height.push_back(0);
+          npixel.push_back(0);
+        }
+        else
+        {
+          id = it->second;
+        }
+
+        seeds[id] = Pixel<int>(i,j, Seeds(i,j));
+        sum_height[id] = Image(i,j);
+        npixel[id] = 1;
+        label[i*ncol+j] = id;
+
+        if (i > 0 && i < nrow-1 && j > 0 && j < ncol-1)
+          frontier.push_back(i*ncol+j);
       }
     }
   }
 
-  while (grown)
+  int di[4] = {-1, 0, 0, 1};
+  int dj[4] = {0, -1, 1, 0};
+
+  while (!frontier.empty())
   {
-    grown = false;
+    bool grown = false;
+    next.clear();
+    added.clear();
 
-    for (int r = 1 ; r < nrow-1 ; r++)                                 // Loops across the entiere image
+    for (unsigned int f = 0 ; f < frontier.size() ; f++)
     {
-      for(int k = 1 ; k < ncol-1 ; k++)
+      int r = frontier[f] / ncol;
+      int k = frontier[f] % ncol;
+      int id = label[frontier[f]];                                      // id of the crown for the current pixel
+
+      Pixel<int> seed = seeds[id];                                      // Get the seed with the label id
+      double hSeed    = Image(seed.i, seed.j);                          // Seed height
+      double mhCrown  = sum_height[id]/npixel[id];                      // Mean height of the crown
+      bool candidate  = false;
+
+      for(int i = 0 ; i < 4 ; i++)                                      // For each neighboring pixel
       {
-        if(Region(r, k) != 0)                                          // If the pixel is already labeled
-        {
-          int id = Region(r, k);                                       // id of the crown for the current pixel
+        int pi = r + di[i];
+        int pj = k + dj[i];
+        int q  = pi*ncol + pj;
 
-          Pixel<int>seed  = seeds[id];                                 // Get the seed with the label id
-          double hSeed    = Image(seed.i, seed.j);                     // Seed height
-          double mhCrown  = sum_height[id]/npixel[id];                 // Mean height of the crown
+        if (label[q] != -1)
+          continue;
 
-          // Elevation of the 4 neighbours
-          neighbours[0] = Pixel<double>(r-1, k, Image(r-1, k));
-          neighbours[1] = Pixel<double>(r, k-1, Image(r, k-1));
-          neighbours[2] = Pixel<double>(r, k+1, Image(r, k+1));
-          neighbours[3] = Pixel<double>(r+1, k, Image(r+1, k));
+        double val = Image(pi, pj);
 
-          for(unsigned int i = 0 ; i < neighbours.size() ; i++)                  // For each neighboring pixel
+        if (val > th_tree &&                                            // The pixel is higher than the minimum value
+            val > hSeed*th_seed &&                                      // La canopée est supérieure à un seuil pour ce pixel
+            val <= hSeed+hSeed*0.05 &&                                  // La canopée est inférieure à un seuil pour ce pixel
+            abs(seed.i-pi) < DIST &&                                    // Le pixel n'est pas trop loin du maximum local sur x
+            abs(seed.j-pj) < DIST)                                      // Le pixel n'est pas trop loin du maximum local sur y
+        {
+          if (val > mhCrown*th_crown)                                   // La canopée est supérieure à un  autre seuil pour ce pixel
           {
-            Pixel<double> px = neighbours[i];
-
-            if (px.val > th_tree)                                       // The pixel is higher than the minimum value)
-            {
-              expend =
-                px.val > hSeed*th_seed &&                               // La canopée est supérieure à un seuil pour ce pixel
-                px.val > mhCrown*th_crown &&                            // La canopée est supérieure à un  autre seuil pour ce pixel
-                px.val <= hSeed+hSeed*0.05 &&                           // La canopée est inférieure à un seuil pour ce pixel
-                abs(seed.i-px.i) < DIST &&                              // Le pixel n'est pas trop loin du maximum local sur x
-                abs(seed.j-px.j) < DIST &&                              // Le pixel n'est pas trop loin du maximum local sur y
-                Region(px.i, px.j) == 0;
-
-              if(expend)                                                // The pixel in part of the region
-              {
-                Regiontemp(px.i, px.j) = Region(r,k);                   // Add the pixel to the region
-                npixel[id]++;
-                sum_height[id] += Image(px.i, px.j);                    // Update the sum of the height of the region
-                grown = true;
-              }
-            }
+            labeltemp[q] = id;                                          // Add the pixel to the region
+            npixel[id]++;
+            sum_height[id] += val;                                      // Update the sum of the height of the region
+            added.push_back(q);
+            grown = true;
+          }
+          else
+          {
+            candidate = true;                                           // The mean height of the crown may change: try again later
           }
         }
       }
+
+      if (candidate)
+        next.push_back(frontier[f]);
     }
 
-    std::copy( Regiontemp.begin(), Regiontemp.end(), Region.begin() );
+    if (!grown)
+      break;
+
+    // Update the labels and add the new pixels to the frontier
+    size_t nold = next.size();
+
+    for (unsigned int a = 0 ; a < added.size() ; a++)
+    {
+      int q = added[a];
+
+      if (label[q] != -1)
+        continue;
+
+      label[q] = labeltemp[q];
+
+      int r = q / ncol;
+      int k = q % ncol;
+
+      if (r > 0 && r < nrow-1 && k > 0 && k < ncol-1)
+        next.push_back(q);
+    }
+
+    std::sort(next.begin() + nold, next.end());
+    std::inplace_merge(next.begin(), next.begin() + nold, next.end());
+    frontier.swap(next);
+  }
+
+  IntegerMatrix Region(nrow, ncol);
+
+  for (int i = 0 ; i < nrow ; i++)
+  {
+    for (int j = 0 ; j < ncol ; j++)
+    {
+      int id = label[i*ncol+j];
+      Region(i,j) = (id == -1) ? 0 : seeds[id].val;
+    }
   }
 
   return(Region);
@@ -28,24 +28,26 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 */
 
 #include <Rcpp.h>
-#include "Point.h"
+#include "LiSegmentation.h"
 #include "Progress.h"
+#include "OutputVector.h"
+#include "LASView.h"
+#include "Instrumentation.h"
 
 using namespace Rcpp;
 
 // [[Rcpp::export]]
-IntegerVector C_lastrees_li(S4 las, double dt1, double dt2, double Zu, double th_tree, double R, bool progressbar = false)
+IntegerVector C_lastrees_li(S4 las, double dt1, double dt2, double Zu, double th_tree, double R, bool progressbar = false, SEXP output = R_NilValue)
 {
-  /* *********************
-   * INITALISATION STUFF *
-   ***********************/
+  KernelScope scope("C_lastrees_li");
 
-  // DataFrame data = las.slot("data");
-  DataFrame data = as<Rcpp::DataFrame>(las.slot("data"));
-
-  NumericVector X = data["X"];
-  NumericVector Y = data["Y"];
-  NumericVector Z = data["Z"];
+  Stage input("input");
+  LASView points(las);
+  NumericVector X = points.X;
+  NumericVector Y = points.Y;
+  NumericVector Z = points.Z;
+  input.add(X.length());
+  input.stop();
 
   S4 header = las.slot("header");
   List phb  = header.slot("PHB");
@@ -53,122 +55,19 @@ IntegerVector C_lastrees_li(S4 las, double dt1, double dt2, double Zu, double th
   double ymin = phb["Min Y"];
 
   unsigned int ni = X.length();            // Number of points
-  unsigned int n  = ni;                    // Number of remaining points
-  unsigned int k  = 1;                     // Current tree ID
-  IntegerVector idtree(ni);       // The ID of each point (returned object)
+
+  // The ID of each point (returned object)
+  IntegerVector idtree = output_vector<INTSXP>(output, ni);
   std::fill(idtree.begin(), idtree.end(), NA_INTEGER);
-  Progress p(ni, progressbar);    // A progress bar and script abort options
-  PointXYZ* dummy = new PointXYZ(xmin-100,ymin-100,0,-1);
-  std::vector<PointXYZ*> P,N;     // Store the point in N or P group (see Li et al.)
-
-  // Reserve memory for N et P group
-  // (will statistically reduce the number of dynamic reallocation)
-  int alloc = 3*R*10;
-  P.reserve(alloc);
-  N.reserve(alloc);
-
-  // Square distance to speed up computation (dont need sqrt)
-  R = R * R;
-  dt1 = dt1 * dt1;
-  dt2 = dt2 * dt2;
-
-  // Convert the R data into STL containers of points
-  std::vector<PointXYZ*> points(ni);
-
-  for (unsigned int i = 0 ; i < ni ; ++i)
-    points[i] = new PointXYZ(X[i], Y[i], Z[i], i);
-
-  /* *********************
-   * LI ET AL ALGORITHHM *
-   ***********************/
-
-  std::sort(points.begin(), points.end(), ZSortPoint());
-
-  while(n > 0)
-  {
-    PointXYZ* u = points[0];
-    std::vector<bool> inN(n);
-
-    // Stop the algo is the highest point u, which is the tree top, is below a threshold
-    // Addition from original algo
-    if (u->z < th_tree)
-    {
-      p.update(ni);
-    }
-    else
-    {
-      // Initial step no point in P or N
-      P.clear();
-      N.clear();
-
-      if (p.check_abort())
-      {
-        for (unsigned int i = 0 ; i < points.size() ; i++) delete points[i];
-        delete dummy;
-        p.exit();
-      }
-      else
-        p.update(ni-n);
-
-      // element 0 is the current highest points and is in P
-      P.push_back(u);
-      idtree[u->id] = k;
-
-      // Add dummy point in N
-      N.push_back(dummy);
-
-      // Compute the distance between the local max u and all the other point
-      std::vector<double> d = sqdistance(points, *u);
-
-      for (unsigned int i = 1 ; i < n ; ++i)
-      {
-        u = points[i];
-
-        if(d[i] > R)            // If d > R those points are not the current segmented tree
-        {
-          inN[i] = true;
-        }
-        else                    // If d <= R classify point base on Li et al. rules
-        {
-          std::vector<double> dP = sqdistance(P, *u);
-          std::vector<double> dN = sqdistance(N, *u);
-
-          double dmin1 = *std::min_element(dP.begin(), dP.end());
-          double dmin2 = *std::min_element(dN.begin(), dN.end());
-          double dt    = (u->z > Zu) ? dt2 : dt1;
-
-          if ( (dmin1 > dt) || ((dmin1 <= dt) && (dmin1 > dmin2)) )
-          {
-            inN[i] = true;
-            N.push_back(u);
-          }
-          else if ((dmin1 <= dt) && (dmin1 <= dmin2))
-          {
-            P.push_back(u);
-            idtree[u->id] = k;
-          }
-        }
-      }
-    }
-
-    // Keep the point in N and redo the loop with remining points
-    std::vector<PointXYZ*> temp;
-    temp.reserve(N.size()-1);
-
-    for(unsigned int i = 0 ; i < n ; i++)
-    {
-      if(inN[i])
-        temp.push_back(points[i]);
-      else
-        delete points[i];
-    }
-
-    points.swap(temp);
-    n = points.size();
-    k++;                        // Increase current tree id
-  }
-
-  delete dummy;
+
+  // A progress bar and script abort options
+  Progress p(ni, progressbar);
+
+  // A dummy point out of the dataset, always in N
+  PointXYZ dummy(xmin-100,ymin-100,0,-1);
+
+  LiSegmentation li(&X[0], &Y[0], &Z[0], ni);
+  li.segment(dt1, dt2, Zu, th_tree, R, std::vector<bool>(), false, dummy, &idtree[0], p);
 
   return idtree;
 }
@@ -0,0 +1,126 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include <Rcpp.h>
+#include <vector>
+#include <cmath>
+#include "QuadTree.h"
+#include "Instrumentation.h"
+#include "myomp.h"
+using namespace Rcpp;
+
+// Silva et al. (2016). Each pixel of the image is given to its nearest tree top (Voronoi
+// tesselation) and is kept only if it is higher than 'exclusion' times the height of the highest
+// pixel of the tree and closer to the tree top than 'max_cr_factor' times this height. Image uses
+// the same layout than in C_lastrees_dalponte i.e. Image(i,j) is the pixel centered on
+// (xmin + (i+0.5)*res, ymin + (j+0.5)*res). The tree tops are labelled 1 to n in their order.
+//[[Rcpp::export]]
+IntegerMatrix C_lastrees_silva(NumericMatrix Image, double xmin, double ymin, double res, NumericVector ttx, NumericVector tty, double max_cr_factor, double exclusion, int ncpu = 1)
+{
+  KernelScope scope("C_lastrees_silva");
+
+  int nrow  = Image.nrow();
+  int ncol  = Image.ncol();
+  int npixel = nrow*ncol;
+  int ntrees = ttx.size();
+
+  IntegerMatrix Crowns(nrow, ncol);
+
+  if (ntrees == 0)
+    return(Crowns);
+
+  Stage build("index build");
+  QuadTree *tree = QuadTreeCreate(ttx, tty);
+  build.add(ntrees);
+  build.stop();
+
+  std::vector<int> id(npixel, -1);
+  std::vector<double> dist(npixel, 0);
+
+  Stage stage("queries");
+  double scanned = 0;
+
+  #pragma omp parallel for num_threads(ncpu) reduction(+:scanned)
+  for (int j = 0 ; j < ncol ; j++)
+  {
+    std::vector<Point> pts;
+
+    for (int i = 0 ; i < nrow ; i++)
+    {
+      int k = j*nrow + i;
+      double z = Image[k];
+
+      if (!std::isfinite(z))
+        continue;
+
+      double x = xmin + (i + 0.5) * res;
+      double y = ymin + (j + 0.5) * res;
+
+      pts.clear();
+      scanned += tree->knn_lookup(x, y, 1, pts);
+
+      double dx = pts[0].x - x;
+      double dy = pts[0].y - y;
+
+      id[k] = pts[0].id;
+      dist[k] = std::sqrt(dx*dx + dy*dy);
+    }
+  }
+
+  stage.add(npixel, scanned);
+  stage.stop();
+
+  delete tree;
+
+  Stage filter("crowns");
+
+  std::vector<double> hmax(ntrees, R_NegInf);
+
+  for (int k = 0 ; k < npixel ; k++)
+  {
+    if (id[k] != -1 && Image[k] > hmax[id[k]])
+      hmax[id[k]] = Image[k];
+  }
+
+  for (int k = 0 ; k < npixel ; k++)
+  {
+    if (id[k] == -1)
+      continue;
+
+    double h = hmax[id[k]];
+
+    if (Image[k] >= exclusion*h && dist[k] <= max_cr_factor*h)
+      Crowns[k] = id[k] + 1;
+  }
+
+  filter.add(npixel);
+  filter.stop();
+
+  return(Crowns);
+}
@@ -0,0 +1,166 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include <Rcpp.h>
+#include <vector>
+#include <cmath>
+#include "Instrumentation.h"
+using namespace Rcpp;
+
+// Priority queue of pixels with integer priorities 0 (highest pixel) to n-1 (lowest pixel). Each
+// priority owns a FIFO bucket so pushing and popping are O(1) and pixels of same priority are
+// popped in the order they were pushed.
+class BucketQueue
+{
+  public:
+    BucketQueue(int n) : buckets(n), head(n, 0), cursor(n), count(0) {}
+    bool empty() const { return count == 0; }
+
+    void push(int priority, int pixel)
+    {
+      buckets[priority].push_back(pixel);
+      if (priority < cursor) cursor = priority;
+      count++;
+    }
+
+    int pop()
+    {
+      while (head[cursor] == buckets[cursor].size())
+      {
+        buckets[cursor].clear();
+        head[cursor] = 0;
+        cursor++;
+      }
+
+      count--;
+      return buckets[cursor][head[cursor]++];
+    }
+
+  private:
+    std::vector< std::vector<int> > buckets;
+    std::vector<size_t> head;
+    int cursor;
+    size_t count;
+};
+
+// Marker controlled watershed by priority flood. The seeds are pushed in the queue first. Each
+// pixel popped gives its label to its unlabelled 8-neighbours higher than th_tree, which are
+// pushed with a priority given by their own height: the crowns are flooded from the top to the
+// bottom and two crowns meet on the valley between them. Heights are binned with a resolution
+// of 'precision' to use a bucket queue, ties are resolved in a first in first out order, so the
+// labels depend only on the image and the seeds. Image must contain -Inf or NA out of the canopy.
+//[[Rcpp::export]]
+IntegerMatrix C_lastrees_watershed(NumericMatrix Image, IntegerMatrix Seeds, double th_tree, double precision = 0.01)
+{
+  KernelScope scope("C_lastrees_watershed");
+
+  const int MAX_BUCKETS = 1 << 20;
+
+  int nrow  = Image.nrow();
+  int ncol  = Image.ncol();
+
+  if (Seeds.nrow() != nrow || Seeds.ncol() != ncol)
+    throw std::runtime_error(std::string("Error: unexpected internal error: different matrix sizes."));
+
+  if (precision <= 0)
+    throw std::runtime_error(std::string("Error: the precision must be positive."));
+
+  IntegerMatrix Crowns(nrow, ncol);
+
+  // Range of the heights that can be flooded
+  double zmax = th_tree;
+  int npixel = nrow*ncol;
+
+  for (int k = 0 ; k < npixel ; k++)
+  {
+    double z = Image[k];
+    if (!ISNAN(z) && z > zmax && z != R_PosInf) zmax = z;
+  }
+
+  int nbuckets = (int)std::min((zmax - th_tree) / precision + 1, (double)MAX_BUCKETS);
+  double scale = (nbuckets - 1) / std::max(zmax - th_tree, precision);
+
+  Stage seeding("seeds");
+
+  BucketQueue queue(nbuckets);
+  std::vector<int> label(npixel, 0);
+
+  for (int k = 0 ; k < npixel ; k++)
+  {
+    double z = Image[k];
+
+    if (Seeds[k] != 0 && !ISNAN(z) && z >= th_tree)
+    {
+      label[k] = Seeds[k];
+      queue.push((int)((zmax - std::min(z, zmax)) * scale), k);
+      seeding.add(1);
+    }
+  }
+
+  seeding.stop();
+
+  Stage flooding("flooding");
+
+  int di[8] = {-1,-1,-1, 0, 0, 1, 1, 1};
+  int dj[8] = {-1, 0, 1,-1, 1,-1, 0, 1};
+
+  while (!queue.empty())
+  {
+    int p = queue.pop();
+    int i = p % nrow;
+    int j = p / nrow;
+
+    flooding.add(1);
+
+    for (int n = 0 ; n < 8 ; n++)
+    {
+      int pi = i + di[n];
+      int pj = j + dj[n];
+
+      if (pi < 0 || pj < 0 || pi >= nrow || pj >= ncol)
+        continue;
+
+      int q = pj*nrow + pi;
+      double z = Image[q];
+
+      if (label[q] != 0 || ISNAN(z) || z < th_tree)
+        continue;
+
+      label[q] = label[p];
+      queue.push((int)((zmax - std::min(z, zmax)) * scale), q);
+    }
+  }
+
+  flooding.stop();
+
+  for (int k = 0 ; k < npixel ; k++)
+    Crowns[k] = label[k];
+
+  return(Crowns);
+}
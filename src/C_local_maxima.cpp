@@ -29,95 +29,189 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 
 #include <Rcpp.h>
 #include <limits>
+#include <algorithm>
+#include <set>
 #include "QuadTree.h"
+#include "LocalMaxima.h"
+#include "SpatialIndex.h"
+#include "Instrumentation.h"
+#include "myomp.h"
 
 using namespace Rcpp;
 
+// Running max of half width h along 'count' lines of n values. Line l holds the values
+// in[l*step + i*stride] and its running max is written at the same place in out (which can
+// be in). The windows are clipped at the ends of the lines. van Herk/Gil-Werman algorithm:
+// 3 comparisons per value whatever the window size.
+static void running_max(const double* in, double* out, int n, int stride, int count, int step, int h, int ncpu)
+{
+  int w = 2*h+1;
+  int m = n + 2*h;
+
+  #pragma omp parallel num_threads(ncpu)
+  {
+    std::vector<double> line(m, -std::numeric_limits<double>::infinity());
+    std::vector<double> g(m), hh(m);
+
+    #pragma omp for
+    for (int l = 0 ; l < count ; l++)
+    {
+      const double* src = in + (size_t)l * step;
+      double* dst = out + (size_t)l * step;
+
+      for (int i = 0 ; i < n ; i++)
+        line[h+i] = src[(size_t)i * stride];
+
+      for (int start = 0 ; start < m ; start += w)
+      {
+        int end = std::min(start + w, m);
+
+        g[start] = line[start];
+        for (int i = start + 1 ; i < end ; i++)
+          g[i] = std::max(g[i-1], line[i]);
+
+        hh[end-1] = line[end-1];
+        for (int i = end - 2 ; i >= start ; i--)
+          hh[i] = std::max(hh[i+1], line[i]);
+      }
+
+      for (int i = 0 ; i < n ; i++)
+        dst[(size_t)i * stride] = std::max(hh[i], g[i+w-1]);
+    }
+  }
+}
+
+// A pixel is a local maximum if it is the highest pixel of the window centred on it, higher
+// than th and if no other local maximum was already found in the window scanning the image
+// row by row. ws is the size of the windows, either a single value or one value per pixel
+// (column-major, NA pixels cannot be local maxima). The max over the windows is computed with
+// a separable running max filter on the raw column-major memory (first along the columns then
+// along the rows), once per distinct window size. Only the candidates are then visited in the
+// scan order to resolve the neighbouring maxima.
 // [[Rcpp::export]]
-IntegerMatrix C_LocalMaximaMatrix(NumericMatrix image, int ws, double th)
+IntegerMatrix C_LocalMaximaMatrix(NumericMatrix image, IntegerVector ws, double th, int ncpu = 1)
 {
   int nrow = image.nrow();
   int ncol = image.ncol();
+  size_t npixels = (size_t)nrow * ncol;
 
-  int minR, minC, maxR, maxC;
-  int index = 1;
-  int fhws = floor((double)ws/2);
+  bool variable = ws.length() != 1;
+
+  if (variable && (size_t)ws.length() != npixels)
+    stop("Internal error: ws must be of length 1 or of the size of the image.");
 
-  NumericMatrix img_neighbours;
-  IntegerMatrix seed_neighbours;
   IntegerMatrix seeds(nrow, ncol);
 
-  for (int r = 0 ; r < nrow ; r++)
+  if (nrow == 0 || ncol == 0)
+    return(seeds);
+
+  const double* img = &image[0];
+
+  // Half width of the window of each pixel (-1 for NA) and the distinct half widths
+  std::vector<int> half(ws.length());
+  std::set<int> widths;
+
+  for (size_t i = 0 ; i < half.size() ; i++)
   {
-    for(int k = 0 ; k <  ncol ; k++)
+    half[i] = (ws[i] == NA_INTEGER) ? -1 : ws[i]/2;
+
+    if (half[i] >= 0 && (!variable || img[i] > th))
+      widths.insert(half[i]);
+  }
+
+  // The center pixel is the highest of its window and this maximum is not too low
+  std::vector<double> mx(npixels);
+  std::vector<size_t> candidates;
+
+  for (std::set<int>::iterator it = widths.begin() ; it != widths.end() ; ++it)
+  {
+    int h = *it;
+
+    running_max(img, &mx[0], nrow, 1, ncol, nrow, h, ncpu);
+    running_max(&mx[0], &mx[0], ncol, nrow, nrow, 1, h, ncpu);
+
+    for (int k = 0 ; k < ncol ; k++)
     {
-      minR = (r - fhws);
-      minC = (k - fhws);
-      maxR = (r + fhws);
-      maxC = (k + fhws);
-
-      minR = minR >= 0 ? minR : 0;
-      minC = minC >= 0 ? minC : 0;
-      maxR = maxR < nrow ? maxR : nrow-1;
-      maxC = maxC < ncol ? maxC : ncol-1;
-
-      img_neighbours  = image(Range(minR,maxR), Range(minC,maxC));
-      seed_neighbours = seeds(Range(minR,maxR), Range(minC,maxC));
-
-      if (image(r,k) == max(img_neighbours) &&                   // If center pixel is the highest
-          max(seed_neighbours) == 0 &&                           // And there is no other seed in the neighborhood
-          image(r,k) > th)                                       // And this maximum is not too low
+      for (int r = 0 ; r < nrow ; r++)
       {
-        seeds(r,k) = index;                                      // Then this pixel is a seed
-        index++;
+        size_t i = (size_t)k * nrow + r;
+
+        if (half[variable ? i : 0] == h && img[i] == mx[i] && img[i] > th)
+          candidates.push_back((size_t)r * ncol + k);
       }
     }
   }
 
+  std::sort(candidates.begin(), candidates.end());
+
+  // Row of the last seed found in each column
+  std::vector<int> last(ncol, std::numeric_limits<int>::min());
+  int index = 1;
+
+  for (size_t c = 0 ; c < candidates.size() ; c++)
+  {
+    int r = candidates[c] / ncol;
+    int k = candidates[c] % ncol;
+    int fhws = half[variable ? (size_t)k * nrow + r : 0];
+
+    int minC = std::max(k - fhws, 0);
+    int maxC = std::min(k + fhws, ncol-1);
+    bool seed = true;
+
+    // There is no other seed in the neighborhood
+    for (int j = minC ; j <= maxC && seed ; j++)
+    {
+      if (last[j] != std::numeric_limits<int>::min() && last[j] >= r - fhws)
+        seed = false;
+    }
+
+    if (seed)
+    {
+      seeds(r,k) = index;                                        // Then this pixel is a seed
+      last[k] = r;
+      index++;
+    }
+  }
+
   return(seeds);
 }
 
+// Local maxima of a point cloud. ws is the size of the windows, either a single value or one
+// value per point. If buffer is given (the buffer column of a buffered cluster of a catalog)
+// only the points of the core (buffer == 0) can be local maxima.
 // [[Rcpp::export]]
-LogicalVector C_LocalMaximaPoints(S4 las, double ws, double min_height)
+LogicalVector C_LocalMaximaPoints(NumericVector X, NumericVector Y, NumericVector Z, NumericVector ws, double min_height, bool circular = false, int ncpu = 1, SEXP index = R_NilValue, SEXP buffer = R_NilValue)
 {
-  DataFrame data  = as<Rcpp::DataFrame>(las.slot("data"));
-  NumericVector X = data["X"];
-  NumericVector Y = data["Y"];
-  NumericVector Z = data["Z"];
+  KernelScope scope("C_LocalMaximaPoints");
 
   int n = X.length();
-  double hws = ws/2;
+
+  if (ws.length() != 1 && ws.length() != n)
+    stop("Internal error: ws must be of length 1 or of the length of the point cloud.");
 
   LogicalVector seeds(n);
-  QuadTree *tree = QuadTreeCreate(X,Y);
 
-  // Loop through all the point cloud
-  for (int i = 0 ; i < n ; i++)
-  {
-    if (Z[i] <= min_height)
-      continue;
+  if (n == 0)
+    return seeds;
 
-    // Get the points within a windows centered on the current point
-    std::vector<Point*> pts;
-    tree->rect_lookup(X[i], Y[i], hws, hws, pts);
+  std::vector<char> skip;
 
-    // Get the highest Z in the windows
-    double Zmax = std::numeric_limits<double>::min();
-    Point *p;
-    for(size_t j = 0 ; j < pts.size() ; j++)
-    {
-      if(Z[pts[j]->id] > Zmax)
-      {
-        p = pts[j];
-        Zmax = Z[p->id];
-      }
-    }
+  if (!Rf_isNull(buffer))
+  {
+    NumericVector b(buffer);
+
+    if (b.length() != n)
+      stop("Internal error: buffer must be of the length of the point cloud.");
 
-    // The central pixel is the highest, it is a LM
-    if (Z[i] == Zmax && X[i] == p->x && Y[i] == p->y)
-      seeds[i] = true;
+    skip.resize(n);
+    for (int i = 0 ; i < n ; i++) skip[i] = b[i] != 0;
   }
 
-  delete tree;
+  IndexedPoints indexed(index, X, Y);
+
+  Stage stage("queries");
+  double scanned = local_maxima_points(*indexed.tree, &X[0], &Y[0], &Z[0], n, &ws[0], ws.length(), circular, min_height, &seeds[0], ncpu, skip.empty() ? 0 : &skip[0]);
+  stage.add(n, scanned);
+
   return seeds;
-}
\ No newline at end of file
+}
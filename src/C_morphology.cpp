@@ -28,81 +28,75 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 */
 
 #include <Rcpp.h>
-#include <limits>
-#include "QuadTree.h"
+#include "MorphologicalFilter.h"
 #include "Progress.h"
+#include "OutputVector.h"
 
 using namespace Rcpp;
 
 // [[Rcpp::export]]
-NumericVector C_MorphologicalOpening(NumericVector X, NumericVector Y, NumericVector Z, double resolution, bool displaybar = false)
+NumericVector C_MorphologicalOpening(NumericVector X, NumericVector Y, NumericVector Z, double resolution, bool displaybar = false, int ncpu = 1, SEXP output = R_NilValue)
 {
-  unsigned int n = X.length();
-  double half_res = resolution / 2;
+  int n = X.length();
 
-  NumericVector Z_temp = clone(Z);
-  NumericVector Z_out  = clone(Z);
+  NumericVector zout = output_vector<REALSXP>(output, n);
 
-  QuadTree *tree = QuadTreeCreate(X,Y);
+  if (n == 0)
+    return zout;
 
-  Progress p(2*n, displaybar);
+  std::vector<bool> active(n, true);
 
-  // Dilate
-  for (unsigned int i = 0 ; i < n ; i++)
-  {
-    std::vector<Point*> pts;
-    tree->rect_lookup(X[i], Y[i], half_res, half_res, pts);
+  MorphologicalFilter filter(&X[0], &Y[0], n);
 
-    double min_pt(std::numeric_limits<double>::max());
+  Progress p(2*n, displaybar);
 
-    for(unsigned  int j = 0 ; j < pts.size() ; j++)
-    {
-      double z = Z_temp[pts[j]->id];
+  filter.opening(&Z[0], active, resolution, &zout[0], p, ncpu);
 
-      if(z < min_pt)
-        min_pt = z;
-    }
+  if (p.check_abort())
+    p.exit();
 
-    Z_out[i] = min_pt;
+  return zout;
+}
 
-    if (p.check_abort())
-    {
-      delete tree;
-      p.exit();
-    }
+// Progressive morphological filter (Zhang et al. 2003). The point cloud is indexed once and
+// each window size filters only the points that remain ground candidates after the previous
+// window. Returns TRUE for the ground points.
+// [[Rcpp::export]]
+LogicalVector C_ProgressiveMorphologicalFilter(NumericVector X, NumericVector Y, NumericVector Z, NumericVector ws, NumericVector th, bool displaybar = false, int ncpu = 1)
+{
+  int n = X.length();
 
-    p.update(i);
-  }
+  if (ws.length() != th.length())
+    stop("Internal error in C_ProgressiveMorphologicalFilter: ws and th have different lengths.");
 
-  Z_temp = clone(Z_out);
+  if (n == 0)
+    return LogicalVector(0);
 
-  // erode
-  for (unsigned int i = 0 ; i < n ; i++)
-  {
-    std::vector<Point*> pts;
-    tree->rect_lookup(X[i], Y[i], half_res, half_res, pts);
+  const double* z = &Z[0];
+  std::vector<bool> ground(n, true);
+  std::vector<double> zopen(n);
 
-    double max_pt(std::numeric_limits<double>::min());
+  MorphologicalFilter filter(&X[0], &Y[0], n);
 
-    for(unsigned int j = 0 ; j < pts.size() ; j++)
-    {
-      double z = Z_temp[pts[j]->id];
+  for (int i = 0 ; i < ws.length() ; i++)
+  {
+    int nground = std::count(ground.begin(), ground.end(), true);
 
-      if(z > max_pt)
-        max_pt = z;
-    }
+    Progress p(2*nground, displaybar);
 
-    Z_out[i] = max_pt;
+    filter.opening(z, ground, ws[i], &zopen[0], p, ncpu);
 
     if (p.check_abort())
-    {
-      delete tree;
       p.exit();
-    }
 
-    p.update(i+n);
+    // Keep only the points whose difference between the source and the opened point cloud
+    // is less than the current height threshold
+    for (int k = 0 ; k < n ; k++)
+    {
+      if (ground[k] && z[k] - zopen[k] >= th[i])
+        ground[k] = false;
+    }
   }
 
-  delete tree;
-  return Z_out;
-}
\ No newline at end of file
+  return wrap(ground);
+}
@@ -29,7 +29,10 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 
 #include <Rcpp.h>
 #include "QuadTree.h"
+#include "SpatialIndex.h"
 #include "Progress.h"
+#include "PolygonIndex.h"
+#include "Instrumentation.h"
 
 using namespace Rcpp;
 
@@ -96,63 +99,76 @@ LogicalVector C_points_in_polygon(NumericVector vertx, NumericVector verty, Nume
   return c;
 }
 
+// QuadTree visitor that assigns the id of a polygon to the points found in this polygon
+struct PolygonLabeler
+{
+  PolygonLabeler(const PolygonIndex& _poly, IntegerVector& _output, int _id) : poly(_poly), output(_output), id(_id) {}
+  void operator()(const Point& p) { if (poly.contains(p.x, p.y)) output(p.id) = id; }
+  const PolygonIndex& poly;
+  IntegerVector& output;
+  int id;
+};
+
 // Do points fall inside a given polygon?
 //
 // Verifies for a set of points whether they fall inside a given polygon
 //
-// @param vertx  numerical list of array of x-coordinates of polygon
-// @param verty  numerical list of array of y-coordinates of polygon
+// @param vertx  list of polygons. Each polygon is a list of the arrays of x-coordinates of its rings
+// (multi parts and holes).
+// @param verty  same for the y-coordinates
 // @param pointx numerical array of x-coordinates of points
 // @param pointy numerical array of y-coordinates of points
 // @return numerical array. 0 if the points are in any polygon or the number of the polygon if points fall in a given polygon
 // @export
 // [[Rcpp::export]]
-IntegerVector C_points_in_polygons(Rcpp::List vertx, Rcpp::List verty, NumericVector pointx, NumericVector pointy, bool displaybar = false)
+IntegerVector C_points_in_polygons(Rcpp::List vertx, Rcpp::List verty, NumericVector pointx, NumericVector pointy, bool displaybar = false, SEXP index = R_NilValue)
 {
+  KernelScope scope("C_points_in_polygons");
+
   int npoints = pointx.length();
-  int nvert   = vertx.length();
+  int npoly   = vertx.length();
   IntegerVector id(npoints);
 
-  QuadTree *tree = QuadTreeCreate(pointx, pointy);
+  IndexedPoints indexed(index, pointx, pointy);
+  QuadTree *tree = indexed.tree;
 
-  Progress p(nvert, displaybar);
+  Progress p(npoly, displaybar);
+  Stage stage("queries");
 
-  for(int i = 0 ; i < nvert ; i ++)
+  for(int i = 0 ; i < npoly ; i ++)
   {
-    NumericVector xpoly = as<NumericVector>(vertx[i]);
-    NumericVector ypoly = as<NumericVector>(verty[i]);
+    List xrings = vertx[i];
+    List yrings = verty[i];
 
-    double xmin = min(xpoly);
-    double xmax = max(xpoly);
-    double ymin = min(ypoly);
-    double ymax = max(ypoly);
+    std::vector< std::vector<double> > x(xrings.size());
+    std::vector< std::vector<double> > y(yrings.size());
 
-    double xc = (xmax + xmin)/2;
-    double yc = (ymax + ymin)/2;
-    double xhw = (xmax - xmin)/2;
-    double yhw = (ymax - ymin)/2;
+    for (int j = 0 ; j < xrings.size() ; j++)
+    {
+      x[j] = as< std::vector<double> >(xrings[j]);
+      y[j] = as< std::vector<double> >(yrings[j]);
+    }
 
-    std::vector<Point*> pts;
-    std::vector<Point*>::iterator it;
-    tree->rect_lookup(xc, yc, xhw, yhw, pts);
+    PolygonIndex poly(x, y);
 
-    for (it = pts.begin() ; it != pts.end() ; ++it)
+    if (poly.xmin <= poly.xmax)
     {
-      if (C_point_in_polygon(xpoly, ypoly, (*it)->x, (*it)->y))
-      {
-        id[(*it)->id] = i+1;
-      }
+      double xc = (poly.xmax + poly.xmin)/2;
+      double yc = (poly.ymax + poly.ymin)/2;
+      double xhw = (poly.xmax - poly.xmin)/2;
+      double yhw = (poly.ymax - poly.ymin)/2;
+
+      PolygonLabeler labeler(poly, id, i+1);
+      stage.add(1, tree->rect_visit(xc, yc, xhw, yhw, labeler));
     }
 
     if (p.check_abort())
     {
-      delete tree;
       p.exit();
     }
 
     p.update(i);
   }
 
-  delete tree;
   return id;
 }
@@ -0,0 +1,102 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+
+#include "RasterProcessors.h"
+
+// Rasterization of a point cloud streamed chunk by chunk into a single raster. The raster is
+// allocated once on the extent of the whole dataset and each chunk of points updates it in
+// place, the chunks are then freed. The statistics are associative so the result does not
+// depend on the way the points are split and no buffer is needed between the chunks.
+
+static PointToRasterProcessor* get_raster_stream(SEXP stream)
+{
+  PointToRasterProcessor* processor = 0;
+
+  if (!Rf_isNull(stream) && TYPEOF(stream) == EXTPTRSXP)
+    processor = (PointToRasterProcessor*)R_ExternalPtrAddr(stream);
+
+  if (processor == 0)
+    stop("Invalid raster stream.");
+
+  return processor;
+}
+
+// Allocates a raster of resolution 'res' that encompasses the bounding box. 'stats' are the
+// statistics computed, see C_rasterize, and 'names' the names of the corresponding layers.
+// [[Rcpp::export]]
+SEXP C_raster_stream_create(double xmin, double ymin, double xmax, double ymax, double res, CharacterVector stats, CharacterVector names)
+{
+  if (names.length() != stats.length())
+    stop("Statistics and names have different lengths.");
+
+  try
+  {
+    PointToRasterProcessor* processor = new PointToRasterProcessor(xmin, ymin, xmax, ymax, res);
+    XPtr<PointToRasterProcessor> ptr(processor, true);
+
+    for (int i = 0 ; i < stats.length() ; i++)
+    {
+      std::string stat = as<std::string>(stats[i]);
+      std::string name = as<std::string>(names[i]);
+      processor->add_layer(stat, name);
+    }
+
+    return ptr;
+  }
+  catch (std::exception const& e)
+  {
+    stop(e.what());
+    return R_NilValue;
+  }
+}
+
+// Adds a chunk of points. ReturnNumber may be empty if no statistic uses the first returns.
+// [[Rcpp::export]]
+void C_raster_stream_update(SEXP stream, NumericVector X, NumericVector Y, NumericVector Z, IntegerVector ReturnNumber, double subcircle = 0)
+{
+  PointToRasterProcessor* processor = get_raster_stream(stream);
+
+  try
+  {
+    processor->rasterize(X, Y, Z, ReturnNumber, subcircle);
+  }
+  catch (std::exception const& e)
+  {
+    stop(e.what());
+  }
+}
+
+// Same output than C_rasterize
+// [[Rcpp::export]]
+List C_raster_stream_values(SEXP stream)
+{
+  PointToRasterProcessor* processor = get_raster_stream(stream);
+  return processor->expend_layers();
+}
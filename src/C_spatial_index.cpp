@@ -0,0 +1,139 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+
+#include <Rcpp.h>
+#include <fstream>
+#include "SpatialIndex.h"
+
+using namespace Rcpp;
+
+static const char INDEX_MAGIC[8] = {'L', 'I', 'D', 'R', 'Q', 'T', '0', '2'};
+
+// quantization = c(xscale, yscale, xoffset, yoffset) from the header of a las file
+static QuadTree::Quantization as_quantization(SEXP quantization)
+{
+  NumericVector q(quantization);
+
+  if (q.length() != 4)
+    stop("Internal error: the quantization must be c(xscale, yscale, xoffset, yoffset).");
+
+  QuadTree::Quantization quant = {q[0], q[1], q[2], q[3]};
+  return quant;
+}
+
+// Builds the spatial index of the points X Y and returns it as an external pointer. If the
+// quantization of the las file is given the points are stored as 32-bit integers when they
+// are exactly on its lattice.
+// [[Rcpp::export]]
+SEXP C_index_build(NumericVector X, NumericVector Y, SEXP quantization = R_NilValue)
+{
+  QuadTree* tree;
+
+  if (Rf_isNull(quantization))
+  {
+    tree = QuadTreeCreate(X, Y);
+  }
+  else
+  {
+    QuadTree::Quantization quant = as_quantization(quantization);
+    tree = QuadTreeCreate(X, Y, &quant);
+  }
+
+  SpatialIndex* si = new SpatialIndex(tree, X.length(), coordinates_fingerprint(X, Y));
+  XPtr<SpatialIndex> ptr(si, true);
+  return ptr;
+}
+
+// Is 'index' a spatial index built on the points X Y?
+// [[Rcpp::export]]
+bool C_index_valid(SEXP index, NumericVector X, NumericVector Y)
+{
+  SpatialIndex* si = get_spatial_index(index);
+  return si != 0 && si->npoints == X.length() && si->fingerprint == coordinates_fingerprint(X, Y);
+}
+
+// Writes a spatial index in a binary file. The file is only meant to be read back on the
+// same kind of machine (native byte order). quantization = c(xscale, yscale, xoffset, yoffset)
+// from the header of the las file: the coordinates are stored as 32-bit integers if they are
+// exactly on this lattice.
+// [[Rcpp::export]]
+void C_index_write(SEXP index, std::string file, SEXP quantization = R_NilValue)
+{
+  SpatialIndex* si = get_spatial_index(index);
+
+  if (si == 0)
+    stop("Invalid spatial index.");
+
+  std::ofstream out(file.c_str(), std::ios::binary);
+
+  if (!out)
+    stop("Cannot write the file " + file);
+
+  out.write(INDEX_MAGIC, 8);
+  out.write((const char*)&si->npoints, sizeof(int));
+  out.write((const char*)&si->fingerprint, sizeof(uint64_t));
+  if (Rf_isNull(quantization))
+  {
+    si->tree->write(out);
+  }
+  else
+  {
+    QuadTree::Quantization quant = as_quantization(quantization);
+    si->tree->write(out, &quant);
+  }
+
+  if (!out)
+    stop("Cannot write the file " + file);
+}
+
+// Reads a spatial index written by C_index_write
+// [[Rcpp::export]]
+SEXP C_index_read(std::string file)
+{
+  std::ifstream in(file.c_str(), std::ios::binary);
+
+  if (!in)
+    stop("Cannot read the file " + file);
+
+  char magic[8];
+  int npoints = 0;
+  uint64_t fingerprint = 0;
+
+  in.read(magic, 8);
+  in.read((char*)&npoints, sizeof(int));
+  in.read((char*)&fingerprint, sizeof(uint64_t));
+
+  if (!in || std::memcmp(magic, INDEX_MAGIC, 8) != 0)
+    stop(file + " is not a spatial index file.");
+
+  QuadTree* tree = new QuadTree(in);
+  XPtr<SpatialIndex> ptr(new SpatialIndex(tree, npoints, fingerprint), true);
+  return ptr;
+}
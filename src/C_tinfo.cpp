@@ -28,60 +28,138 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>
 */
 
 #include <Rcpp.h>
+#include <cmath>
+#include <string>
+#include <algorithm>
+
 using namespace Rcpp;
 
-// @param M a matrix n x 4 describing a delaunay triangulation. Each row a set of indices to the points + a triangle id
+enum TriangleInfo {NX = 0, NY, NZ, INTERCEPT, XYZAREA, XYAREA, MAXEDGE};
+static const char* TINFO_NAMES[] = {"nx", "ny", "nz", "intercept", "xyzarea", "xyarea", "maxedge"};
+static const int TINFO_NCOLS = 7;
+static const int TINFO_BLOCK = 512;
+
+// @param M a matrix n x 3 (or n x 4) describing a delaunay triangulation. Each row a set of indices to the points (+ a triangle id)
 // This matrix is expected to be pruned of useless triangles in attempt to reduce the computation times
 // @param X a matrix m x 3 with the points coordinates
-// @param size the number of triangle in original dataset
-// @return n x 6 matrix with 3 coord of normal vector, intercept, area, projected area, max edge size
+// @param columns NULL for all the columns or the names of the columns to compute
+// @return n x 7 matrix with 3 coord of normal vector, intercept, area, projected area, max edge size
+// or only the requested columns in the requested order.
+//
+// The triangles are processed by blocks. The coordinates of the vertices of each block are
+// gathered into structure of arrays, then each column is computed by a tight loop over the
+// block, written directly in the column-major output.
 // [[Rcpp::export]]
-NumericMatrix C_tinfo(IntegerMatrix M, NumericMatrix X)
+NumericMatrix C_tinfo(IntegerMatrix M, NumericMatrix X, SEXP columns = R_NilValue)
 {
-  NumericMatrix N(M.nrow(), 7);
+  std::vector<int> cols;
+
+  if (Rf_isNull(columns))
+  {
+    for (int k = 0 ; k < TINFO_NCOLS ; k++) cols.push_back(k);
+  }
+  else
+  {
+    CharacterVector names(columns);
+
+    for (int k = 0 ; k < names.size() ; k++)
+    {
+      std::string name = as<std::string>(names[k]);
+      int c = std::find(TINFO_NAMES, TINFO_NAMES + TINFO_NCOLS, name) - TINFO_NAMES;
+
+      if (c == TINFO_NCOLS)
+        stop("Unknown triangle information '" + name + "'");
+
+      cols.push_back(c);
+    }
+  }
+
+  int ntri = M.nrow();
+  int npts = X.nrow();
+  int ncols = cols.size();
+  NumericMatrix N(ntri, ncols);
   std::fill(N.begin(), N.end(), NA_REAL);
 
-  for (int i = 0, end = M.nrow() ; i < end ; i++)
+  const int* m1 = &M[0];
+  const int* m2 = m1 + ntri;
+  const int* m3 = m2 + ntri;
+  const double* x = &X[0];
+  const double* y = x + npts;
+  const double* z = y + npts;
+
+  // Vertices and derived quantities of a block, structure of arrays
+  double ux[TINFO_BLOCK], uy[TINFO_BLOCK], uz[TINFO_BLOCK];
+  double vx[TINFO_BLOCK], vy[TINFO_BLOCK], vz[TINFO_BLOCK];
+  double wx[TINFO_BLOCK], wy[TINFO_BLOCK];
+  double cx[TINFO_BLOCK], cy[TINFO_BLOCK], cz[TINFO_BLOCK];
+  double nx[TINFO_BLOCK], ny[TINFO_BLOCK], nz[TINFO_BLOCK];
+
+  bool need_normal = false;
+  for (int k = 0 ; k < ncols ; k++) need_normal |= cols[k] != MAXEDGE;
+
+  for (int start = 0 ; start < ntri ; start += TINFO_BLOCK)
   {
-    int p1 = M(i,0)-1;
-    int p2 = M(i,1)-1;
-    int p3 = M(i,2)-1;
+    int len = std::min(TINFO_BLOCK, ntri - start);
 
-    NumericVector A = NumericVector::create(X(p1,0), X(p1,1), X(p1,2));
-    NumericVector B = NumericVector::create(X(p2,0), X(p2,1), X(p2,2));
-    NumericVector C = NumericVector::create(X(p3,0), X(p3,1), X(p3,2));
+    // Gather: u = A - B, v = A - C, w = B - C
+    for (int t = 0 ; t < len ; t++)
+    {
+      int p1 = m1[start + t] - 1;
+      int p2 = m2[start + t] - 1;
+      int p3 = m3[start + t] - 1;
 
-    NumericVector u = A - B;
-    NumericVector v = A - C;
-    NumericVector w = B - C;
+      cx[t] = x[p3]; cy[t] = y[p3]; cz[t] = z[p3];
+      ux[t] = x[p1] - x[p2]; uy[t] = y[p1] - y[p2]; uz[t] = z[p1] - z[p2];
+      vx[t] = x[p1] - cx[t]; vy[t] = y[p1] - cy[t]; vz[t] = z[p1] - cz[t];
+      wx[t] = x[p2] - cx[t]; wy[t] = y[p2] - cy[t];
+    }
 
     // Cross product
-    NumericVector n(3);
-    n(0) = u(1)*v(2)-u(2)*v(1);
-    n(1) = u(2)*v(0)-u(0)*v(2);
-    n(2) = u(0)*v(1)-u(1)*v(0);
-
-    // normal vector
-    N(i,0) = n(0);
-    N(i,1) = n(1);
-    N(i,2) = n(2);
-
-    // intercept
-    N(i,3) = sum(-n*C);
-
-    // area and projected area
-    N(i,4) = std::fabs(0.5 * sqrt(n(0) * n(0) + n(1) * n(1) + n(2) * n(2)));
-    N(i,5) = std::fabs(0.5 * n(2));
-
-    // max edge length
-    u.erase(2);
-    v.erase(2);
-    w.erase(2);
-    NumericVector e = NumericVector::create(sqrt(sum(pow(u, 2))), sqrt(sum(pow(v, 2))), sqrt(sum(pow(w, 2))));
-    N(i,6) = max(e);
+    if (need_normal)
+    {
+      for (int t = 0 ; t < len ; t++)
+      {
+        nx[t] = uy[t]*vz[t] - uz[t]*vy[t];
+        ny[t] = uz[t]*vx[t] - ux[t]*vz[t];
+        nz[t] = ux[t]*vy[t] - uy[t]*vx[t];
+      }
+    }
+
+    for (int k = 0 ; k < ncols ; k++)
+    {
+      double* out = &N[0] + (size_t)k * ntri + start;
+
+      switch (cols[k])
+      {
+        case NX: std::copy(nx, nx + len, out); break;
+        case NY: std::copy(ny, ny + len, out); break;
+        case NZ: std::copy(nz, nz + len, out); break;
+        case INTERCEPT:
+          for (int t = 0 ; t < len ; t++) out[t] = -(nx[t]*cx[t] + ny[t]*cy[t] + nz[t]*cz[t]);
+          break;
+        case XYZAREA:
+          for (int t = 0 ; t < len ; t++) out[t] = 0.5 * std::sqrt(nx[t]*nx[t] + ny[t]*ny[t] + nz[t]*nz[t]);
+          break;
+        case XYAREA:
+          for (int t = 0 ; t < len ; t++) out[t] = std::fabs(0.5 * nz[t]);
+          break;
+        case MAXEDGE:
+          for (int t = 0 ; t < len ; t++)
+          {
+            double eu = ux[t]*ux[t] + uy[t]*uy[t];
+            double ev = vx[t]*vx[t] + vy[t]*vy[t];
+            double ew = wx[t]*wx[t] + wy[t]*wy[t];
+            double e = eu > ev ? eu : ev;
+            out[t] = std::sqrt(e > ew ? e : ew);
+          }
+          break;
+      }
+    }
   }
 
-  colnames(N) = CharacterVector::create("nx", "ny", "nz", "intercept", "xyzarea", "xyarea", "maxedge");
+  CharacterVector names(ncols);
+  for (int k = 0 ; k < ncols ; k++) names[k] = TINFO_NAMES[cols[k]];
+  colnames(N) = names;
 
   return N;
 }
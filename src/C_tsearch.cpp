@@ -29,21 +29,36 @@
 
 #include <Rcpp.h>
 #include "QuadTree.h"
+#include "SpatialIndex.h"
 #include "Progress.h"
+#include "Instrumentation.h"
 
 using namespace Rcpp;
 
+// QuadTree visitor that assigns a triangle id to the points found in this triangle
+struct TriangleLabeler
+{
+  TriangleLabeler(IntegerVector& _output, int _id) : output(_output), id(_id) {}
+  void operator()(const Point& p) { output(p.id) = id; }
+  IntegerVector& output;
+  int id;
+};
+
 // [[Rcpp::export]]
-IntegerVector C_tsearch(NumericVector x, NumericVector y, IntegerMatrix elem, NumericVector xi, NumericVector yi, bool diplaybar = false)
+IntegerVector C_tsearch(NumericVector x, NumericVector y, IntegerMatrix elem, NumericVector xi, NumericVector yi, bool diplaybar = false, SEXP index = R_NilValue)
 {
   // Algorithm
 
-  QuadTree *tree = QuadTreeCreate(xi,yi);
+  KernelScope scope("C_tsearch");
+
+  IndexedPoints indexed(index, xi, yi);
+  QuadTree *tree = indexed.tree;
 
   int nelem = elem.nrow();
   int np = xi.size();
 
   Progress p(nelem, diplaybar);
+  Stage stage("queries");
 
   IntegerVector output(np);
   std::fill(output.begin(), output.end(), NA_INTEGER);
@@ -61,26 +76,97 @@ IntegerVector C_tsearch(NumericVector x, NumericVector y, IntegerMatrix elem, Nu
     Point B(x(iB), y(iB));
     Point C(x(iC), y(iC));
 
-    // QuadTree search of points in the triangle
-    std::vector<Point*> points;
-    tree->triangle_lookup(A, B, C, points);
+    // QuadTree search of points in the triangle and assignment of the id of the triangle
+    TriangleLabeler labeler(output, k + 1);
+    stage.add(1, tree->triangle_visit(A, B, C, labeler));
 
-    // Return the id of the triangle
-    for(std::vector<Point*>::iterator it = points.begin(); it != points.end(); it++)
+    if (p.check_abort())
     {
-        int id = (*it)->id;
-        output(id) = k + 1;
+      p.exit();
     }
 
+    p.update(k);
+  }
+
+  return(output);
+}
+
+// QuadTree visitor that interpolates the points found in a triangle using the plane of the triangle
+struct TriangleInterpolator
+{
+  TriangleInterpolator(NumericVector& _output) : output(_output), nx(0), ny(0), nz(0), intercept(0), deleted(false) {}
+
+  void operator()(const Point& p)
+  {
+    output(p.id) = deleted ? NA_REAL : -(p.x * nx + p.y * ny + intercept) / nz;
+  }
+
+  NumericVector& output;
+  double nx, ny, nz, intercept;
+  bool deleted;
+};
+
+// Linear interpolation of the points (xi, yi) on a Delaunay triangulation D of the points (X,Y,Z).
+// Fuses C_tsearch and C_tinfo: each triangle visits the points it contains and writes directly the
+// interpolated value using its own plane, without storing the triangle of each point nor the
+// normal vectors of all the triangles. If maxedge > 0 the triangles having an edge longer than
+// maxedge are removed on the fly (pit-free algorithm). Like C_tsearch, a point shared by several
+// triangles gets the value of the last one. index is the spatial index of (xi, yi) if any.
+// [[Rcpp::export]]
+NumericVector C_tinterpolate(NumericVector X, NumericVector Y, NumericVector Z, IntegerMatrix D, NumericVector xi, NumericVector yi, double maxedge = 0, bool displaybar = false, SEXP index = R_NilValue)
+{
+  KernelScope scope("C_tinterpolate");
+
+  IndexedPoints indexed(index, xi, yi);
+  QuadTree *tree = indexed.tree;
+
+  int nelem = D.nrow();
+  int np = xi.size();
+
+  Progress p(nelem, displaybar);
+
+  NumericVector output(np);
+  std::fill(output.begin(), output.end(), NA_REAL);
+
+  TriangleInterpolator interpolator(output);
+  Stage stage("interpolation");
+
+  for (int k = 0; k < nelem; k++)
+  {
+    int iA = D(k, 0) - 1;
+    int iB = D(k, 1) - 1;
+    int iC = D(k, 2) - 1;
+
+    Point A(X(iA), Y(iA));
+    Point B(X(iB), Y(iB));
+    Point C(X(iC), Y(iC));
+
+    double u[3] = {X(iA) - X(iB), Y(iA) - Y(iB), Z(iA) - Z(iB)};
+    double v[3] = {X(iA) - X(iC), Y(iA) - Y(iC), Z(iA) - Z(iC)};
+    double w[2] = {X(iB) - X(iC), Y(iB) - Y(iC)};
+
+    // Normal vector (cross product) and intercept of the plane
+    interpolator.nx = u[1]*v[2]-u[2]*v[1];
+    interpolator.ny = u[2]*v[0]-u[0]*v[2];
+    interpolator.nz = u[0]*v[1]-u[1]*v[0];
+    interpolator.intercept = (-interpolator.nx*X(iC)) + (-interpolator.ny*Y(iC)) + (-interpolator.nz*Z(iC));
+
+    // Max edge length
+    if (maxedge > 0)
+    {
+      double e = std::max(sqrt(u[0]*u[0] + u[1]*u[1]), std::max(sqrt(v[0]*v[0] + v[1]*v[1]), sqrt(w[0]*w[0] + w[1]*w[1])));
+      interpolator.deleted = e > maxedge;
+    }
+
+    stage.add(1, tree->triangle_visit(A, B, C, interpolator));
+
     if (p.check_abort())
     {
-      delete tree;
       p.exit();
     }
 
     p.update(k);
   }
 
-  delete tree;
   return(output);
 }
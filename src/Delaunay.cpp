@@ -0,0 +1,729 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include "Delaunay.h"
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+
+struct HilbertKey
+{
+  uint64_t code;
+  int idx;
+  bool operator<(const HilbertKey& other) const { return code < other.code; }
+};
+
+// Index of the cell (x,y) along a Hilbert curve that covers a 2^16 x 2^16 grid
+static inline uint64_t hilbert_code(uint32_t x, uint32_t y)
+{
+  const uint32_t n = 1 << 16;
+  uint64_t d = 0;
+
+  for (uint32_t s = n >> 1 ; s > 0 ; s >>= 1)
+  {
+    uint32_t rx = (x & s) > 0;
+    uint32_t ry = (y & s) > 0;
+    d += (uint64_t)s * s * ((3 * rx) ^ ry);
+
+    if (ry == 0)
+    {
+      if (rx == 1)
+      {
+        x = n - 1 - x;
+        y = n - 1 - y;
+      }
+
+      std::swap(x, y);
+    }
+  }
+
+  return d;
+}
+
+// Exact arithmetic on floating point expansions (Shewchuk 1997): a number is stored as a
+// sum of non-overlapping doubles sorted by increasing magnitude so its sign is the sign of
+// its last component. Zero components are eliminated so the expansions usually stay short.
+// Only used when the filtered predicates cannot decide.
+static const double EPSILON  = std::ldexp(1.0, -53);
+static const double SPLITTER = std::ldexp(1.0, 27) + 1;
+static const double ORIENT_ERRBOUND   = (3 + 16 * EPSILON) * EPSILON;
+static const double INCIRCLE_ERRBOUND = (10 + 96 * EPSILON) * EPSILON;
+static const int MAX_PRODUCT = 512;
+
+static inline void two_sum(double a, double b, double& x, double& y)
+{
+  x = a + b;
+  double bv = x - a;
+  y = (a - (x - bv)) + (b - bv);
+}
+
+static inline void split(double a, double& hi, double& lo)
+{
+  double c = SPLITTER * a;
+  hi = c - (c - a);
+  lo = a - hi;
+}
+
+static inline void two_product(double a, double b, double& x, double& y)
+{
+  x = a * b;
+  double ahi, alo, bhi, blo;
+  split(a, ahi, alo);
+  split(b, bhi, blo);
+  y = alo * blo - (((x - ahi * bhi) - alo * bhi) - ahi * blo);
+}
+
+// h = a - b exactly (at most 2 components)
+static inline int difference(double a, double b, double* h)
+{
+  double x, y;
+  two_sum(a, -b, x, y);
+  int n = 0;
+  if (y != 0) h[n++] = y;
+  if (x != 0) h[n++] = x;
+  return n;
+}
+
+// h = e + f (at most elen + flen components). h must not overlap e or f.
+static int sum(int elen, const double* e, int flen, const double* f, double* h)
+{
+  int i = 0, j = 0, n = 0;
+  double q = 0, hh;
+
+  while (i < elen || j < flen)
+  {
+    double g = (j == flen || (i < elen && std::fabs(e[i]) < std::fabs(f[j]))) ? e[i++] : f[j++];
+
+    if (i + j == 1)
+    {
+      q = g;
+      continue;
+    }
+
+    two_sum(q, g, q, hh);
+    if (hh != 0) h[n++] = hh;
+  }
+
+  if (q != 0) h[n++] = q;
+  return n;
+}
+
+// h = b * e (at most 2 * elen components)
+static int scale(int elen, const double* e, double b, double* h)
+{
+  if (elen == 0 || b == 0)
+    return 0;
+
+  int n = 0;
+  double q, hh, p, t;
+  two_product(e[0], b, q, hh);
+  if (hh != 0) h[n++] = hh;
+
+  for (int i = 1 ; i < elen ; i++)
+  {
+    two_product(e[i], b, p, t);
+    two_sum(q, t, q, hh);
+    if (hh != 0) h[n++] = hh;
+    two_sum(p, q, q, hh);
+    if (hh != 0) h[n++] = hh;
+  }
+
+  if (q != 0) h[n++] = q;
+  return n;
+}
+
+// h = e * f (at most 2 * elen * flen <= MAX_PRODUCT components, elen <= 16)
+static int product(int elen, const double* e, int flen, const double* f, double* h)
+{
+  if (flen == 1)
+    return scale(elen, e, f[0], h);
+
+  double part[32];
+  double acc[2][MAX_PRODUCT];
+  int n = 0;
+  int cur = 0;
+
+  for (int j = 0 ; j < flen ; j++)
+  {
+    int m = scale(elen, e, f[j], part);
+    n = sum(n, acc[cur], m, part, acc[1 - cur]);
+    cur = 1 - cur;
+  }
+
+  std::copy(acc[cur], acc[cur] + n, h);
+  return n;
+}
+
+// h = a * b - c * d (at most 16 components for inputs of 2 components)
+static int cross(int alen, const double* a, int blen, const double* b, int clen, const double* c, int dlen, const double* d, double* h)
+{
+  double ab[8], cd[8];
+  int n1 = product(alen, a, blen, b, ab);
+  int n2 = product(clen, c, dlen, d, cd);
+
+  for (int i = 0 ; i < n2 ; i++)
+    cd[i] = -cd[i];
+
+  return sum(n1, ab, n2, cd, h);
+}
+
+static inline double sign(int n, const double* e)
+{
+  if (n == 0) return 0;
+  return e[n - 1] > 0 ? 1 : -1;
+}
+
+// Exact sign of the orientation determinant
+static double orient_exact(double ax, double ay, double bx, double by, double cx, double cy)
+{
+  double bax[2], bay[2], cax[2], cay[2], e[16];
+  int nbax = difference(bx, ax, bax);
+  int nbay = difference(by, ay, bay);
+  int ncax = difference(cx, ax, cax);
+  int ncay = difference(cy, ay, cay);
+  int n = cross(nbax, bax, ncay, cay, nbay, bay, ncax, cax, e);
+
+  return sign(n, e);
+}
+
+// Exact sign of the incircle determinant, expanded along the lifted coordinates
+static double incircle_exact(double ax, double ay, double bx, double by, double cx, double cy, double px, double py)
+{
+  double d[6][2];
+  int nd[6];
+  nd[0] = difference(ax, px, d[0]); nd[1] = difference(ay, py, d[1]);
+  nd[2] = difference(bx, px, d[2]); nd[3] = difference(by, py, d[3]);
+  nd[4] = difference(cx, px, d[4]); nd[5] = difference(cy, py, d[5]);
+
+  double sq1[8], sq2[8], lift[16], minor[16], term[MAX_PRODUCT];
+  double acc[2][3*MAX_PRODUCT];
+  int n = 0;
+  int cur = 0;
+
+  for (int k = 0 ; k < 3 ; k++)
+  {
+    int u = 2 * k;              // lifted vertex
+    int v = 2 * ((k + 1) % 3);  // next vertex
+    int w = 2 * ((k + 2) % 3);  // previous vertex
+
+    int n1 = product(nd[u], d[u], nd[u], d[u], sq1);
+    int n2 = product(nd[u+1], d[u+1], nd[u+1], d[u+1], sq2);
+    int nl = sum(n1, sq1, n2, sq2, lift);
+    int nm = cross(nd[v], d[v], nd[w+1], d[w+1], nd[w], d[w], nd[v+1], d[v+1], minor);
+    int nt = product(nm, minor, nl, lift, term);
+
+    n = sum(n, acc[cur], nt, term, acc[1 - cur]);
+    cur = 1 - cur;
+  }
+
+  return sign(n, acc[cur]);
+}
+
+Delaunay::Delaunay(const double* X, const double* Y, int n)
+{
+  npoints = n;
+  INF = npoints;
+  last = -1;
+  seed = 2463534242u;
+  stamp = 0;
+
+  if (npoints == 0)
+    return;
+
+  // The predicates are computed relative to the center of the point cloud to save the
+  // precision lost with large coordinates (e.g. UTM)
+  double xmin = *std::min_element(X, X + n);
+  double xmax = *std::max_element(X, X + n);
+  double ymin = *std::min_element(Y, Y + n);
+  double ymax = *std::max_element(Y, Y + n);
+  double xc = (xmin + xmax) / 2;
+  double yc = (ymin + ymax) / 2;
+
+  x.resize(npoints);
+  y.resize(npoints);
+
+  for (int i = 0 ; i < npoints ; i++)
+  {
+    x[i] = X[i] - xc;
+    y[i] = Y[i] - yc;
+  }
+}
+
+Delaunay::~Delaunay()
+{
+}
+
+void Delaunay::triangulate(Progress& progress)
+{
+  tri.clear();
+  twin.clear();
+  alive.clear();
+  holes.clear();
+
+  if (npoints < 3)
+    return;
+
+  // A triangulation has at most 2n triangles, ghosts included
+  tri.reserve(6 * npoints);
+  twin.reserve(6 * npoints);
+  alive.reserve(2 * npoints);
+  start.assign(npoints + 1, -1);
+
+  std::vector<int> order;
+  brio(order);
+
+  int a, b, c;
+  if (!init(order, a, b, c))
+    return;
+
+  for (int i = 0 ; i < npoints ; i++)
+  {
+    if (progress.check_abort())
+      progress.exit();
+
+    int p = order[i];
+
+    if (p != a && p != b && p != c)
+      insert(p);
+
+    progress.increment();
+  }
+
+  return;
+}
+
+int Delaunay::ntriangles()
+{
+  int n = 0;
+
+  for (int t = 0 ; t < (int)alive.size() ; t++)
+  {
+    if (alive[t] && !is_ghost(t))
+      n++;
+  }
+
+  return n;
+}
+
+// Vertices of the finite triangles. 3 indices per triangle, counterclockwise.
+void Delaunay::get_triangles(std::vector<int>& triangles)
+{
+  triangles.clear();
+  triangles.reserve(3 * ntriangles());
+
+  for (int t = 0 ; t < (int)alive.size() ; t++)
+  {
+    if (alive[t] && !is_ghost(t))
+    {
+      triangles.push_back(tri[3*t]);
+      triangles.push_back(tri[3*t+1]);
+      triangles.push_back(tri[3*t+2]);
+    }
+  }
+
+  return;
+}
+
+// Biased randomized insertion order: the points are shuffled then split into rounds of size
+// n/2, n/4, n/8, ... inserted from the smallest to the largest. Each round is sorted along a
+// Hilbert curve. The random rounds preserve the expected complexity of a randomized
+// insertion while the Hilbert order keeps the point location walks short.
+void Delaunay::brio(std::vector<int>& order)
+{
+  order.resize(npoints);
+
+  for (int i = 0 ; i < npoints ; i++)
+    order[i] = i;
+
+  for (int i = npoints - 1 ; i > 0 ; i--)
+    std::swap(order[i], order[rand_next() % (i + 1)]);
+
+  double xmin = *std::min_element(x.begin(), x.end());
+  double xmax = *std::max_element(x.begin(), x.end());
+  double ymin = *std::min_element(y.begin(), y.end());
+  double ymax = *std::max_element(y.begin(), y.end());
+  double range = std::max(xmax - xmin, ymax - ymin);
+  double scale = range > 0 ? 65535 / range : 0;
+
+  std::vector<HilbertKey> keys(npoints);
+
+  int end = npoints;
+
+  while (end > 0)
+  {
+    int begin = end / 2;
+
+    if (begin < MIN_ROUND)
+      begin = 0;
+
+    for (int i = begin ; i < end ; i++)
+    {
+      int k = order[i];
+      keys[i].code = hilbert_code((uint32_t)((x[k] - xmin) * scale), (uint32_t)((y[k] - ymin) * scale));
+      keys[i].idx = k;
+    }
+
+    std::sort(keys.begin() + begin, keys.begin() + end);
+
+    for (int i = begin ; i < end ; i++)
+      order[i] = keys[i].idx;
+
+    end = begin;
+  }
+
+  return;
+}
+
+// First triangle made of the two first distinct points and the first point not aligned
+// with them. Its three edges are closed with ghost triangles. Returns false if all the
+// points are aligned.
+bool Delaunay::init(const std::vector<int>& order, int& a, int& b, int& c)
+{
+  a = order[0];
+  b = -1;
+  c = -1;
+
+  int i = 1;
+
+  for ( ; i < npoints ; i++)
+  {
+    int k = order[i];
+
+    if (x[k] != x[a] || y[k] != y[a])
+    {
+      b = k;
+      break;
+    }
+  }
+
+  if (b == -1)
+    return false;
+
+  for ( ; i < npoints ; i++)
+  {
+    int k = order[i];
+
+    if (orient(a, b, k) != 0)
+    {
+      c = k;
+      break;
+    }
+  }
+
+  if (c == -1)
+    return false;
+
+  if (orient(a, b, c) < 0)
+    std::swap(a, b);
+
+  int t0 = new_triangle(a, b, c);
+  int g1 = new_triangle(b, a, INF);
+  int g2 = new_triangle(c, b, INF);
+  int g3 = new_triangle(a, c, INF);
+
+  // a->b, b->c, c->a with their ghosts
+  twin[3*t0]   = 3*g1;   twin[3*g1]   = 3*t0;
+  twin[3*t0+1] = 3*g2;   twin[3*g2]   = 3*t0+1;
+  twin[3*t0+2] = 3*g3;   twin[3*g3]   = 3*t0+2;
+
+  // Edges to the vertex at infinity
+  twin[3*g1+1] = 3*g3+2; twin[3*g3+2] = 3*g1+1;  // a->INF
+  twin[3*g2+1] = 3*g1+2; twin[3*g1+2] = 3*g2+1;  // b->INF
+  twin[3*g3+1] = 3*g2+2; twin[3*g2+2] = 3*g3+1;  // c->INF
+
+  last = t0;
+  mark.assign(alive.size(), 0);
+
+  return true;
+}
+
+// Bowyer-Watson insertion: the triangles whose circumcircle contains p are removed and the
+// cavity is re-triangulated with p. A triangle joins the cavity only through an edge that p
+// sees from the right side so the cavity stays star shaped even if the incircle test is
+// wrong because of rounding errors.
+bool Delaunay::insert(int p)
+{
+  int t0 = locate(p);
+
+  if (t0 == -1)
+    return false;
+
+  stamp++;
+  cavity.clear();
+  boundary.clear();
+  cavity.push_back(t0);
+  mark[t0] = stamp;
+
+  for (int k = 0 ; k < (int)cavity.size() ; k++)
+  {
+    int t = cavity[k];
+
+    for (int e = 3*t ; e < 3*t+3 ; e++)
+    {
+      int h = twin[e];
+      int nt = h / 3;
+
+      if (mark[nt] == stamp)
+        continue;
+
+      int u = tri[e];
+      int v = tri[next(e)];
+      bool visible = u == INF || v == INF || orient(u, v, p) > 0;
+
+      if (conflict(nt, p) || (!visible && !is_ghost(nt)))
+      {
+        cavity.push_back(nt);
+        mark[nt] = stamp;
+      }
+    }
+  }
+
+  // The boundary of the cavity, the edges of the removed triangles connected to a triangle
+  // that is kept
+  for (int k = 0 ; k < (int)cavity.size() ; k++)
+  {
+    int t = cavity[k];
+
+    for (int e = 3*t ; e < 3*t+3 ; e++)
+    {
+      if (mark[twin[e] / 3] != stamp)
+        boundary.push_back(twin[e]);
+    }
+  }
+
+  for (int k = 0 ; k < (int)cavity.size() ; k++)
+    delete_triangle(cavity[k]);
+
+  // One new triangle per boundary edge. The edge u->v of the cavity is the twin of the edge
+  // v->u of a kept triangle.
+  for (int k = 0 ; k < (int)boundary.size() ; k++)
+  {
+    int h = boundary[k];
+    int u = tri[next(h)];
+    int v = tri[h];
+    int t = new_triangle(u, v, p);
+
+    twin[3*t] = h;
+    twin[h] = 3*t;
+    start[u] = t;
+  }
+
+  // Connects the new triangles around p: the edge v->p of the triangle (u,v,p) is the twin
+  // of the edge p->v of the triangle (v,w,p)
+  for (int k = 0 ; k < (int)boundary.size() ; k++)
+  {
+    int t = twin[boundary[k]] / 3;
+    int v = tri[3*t+1];
+    int s = start[v];
+
+    twin[3*t+1] = 3*s+2;
+    twin[3*s+2] = 3*t+1;
+  }
+
+  last = twin[boundary[0]] / 3;
+
+  return true;
+}
+
+// Visibility walk from the last triangle created toward p. Returns a triangle in conflict
+// with p or -1 if p is a duplicated point.
+int Delaunay::locate(int p)
+{
+  int t = last;
+
+  if (!alive[t])
+  {
+    t = 0;
+    while (!alive[t]) t++;
+  }
+
+  if (is_ghost(t))
+  {
+    int e = 3*t;
+    while (tri[e] == INF || tri[next(e)] == INF) e++;
+
+    if (conflict(t, p))
+      return t;
+
+    t = twin[e] / 3;
+  }
+
+  int maxiter = 4 * alive.size();
+
+  for (int iter = 0 ; iter < maxiter ; iter++)
+  {
+    int e0 = 3*t;
+    int r = rand_next() % 3;
+    bool moved = false;
+
+    for (int j = 0 ; j < 3 ; j++)
+    {
+      int e = e0 + (r + j) % 3;
+
+      if (orient(tri[e], tri[next(e)], p) < 0)
+      {
+        t = twin[e] / 3;
+        moved = true;
+        break;
+      }
+    }
+
+    if (!moved)
+      break;
+
+    // p is out of the convex hull of the points already inserted
+    if (is_ghost(t))
+      return t;
+  }
+
+  for (int k = 3*t ; k < 3*t+3 ; k++)
+  {
+    int q = tri[k];
+
+    if (x[q] == x[p] && y[q] == y[p])
+      return -1;
+  }
+
+  return t;
+}
+
+// p is strictly in the circumcircle of t. For a ghost triangle, whose finite edge is a->b,
+// the circle degenerates to the half plane on the left of a->b plus the open segment ]a,b[.
+bool Delaunay::conflict(int t, int p)
+{
+  int a = tri[3*t];
+  int b = tri[3*t+1];
+  int c = tri[3*t+2];
+
+  if (a == INF)      { a = b; b = c; }
+  else if (b == INF) { b = a; a = c; }
+  else if (c != INF) return incircle(a, b, c, p) > 0;
+
+  double o = orient(a, b, p);
+
+  if (o > 0)
+    return true;
+
+  if (o < 0)
+    return false;
+
+  double d1 = (x[p] - x[a]) * (x[b] - x[a]) + (y[p] - y[a]) * (y[b] - y[a]);
+  double d2 = (x[p] - x[b]) * (x[a] - x[b]) + (y[p] - y[b]) * (y[a] - y[b]);
+
+  return d1 > 0 && d2 > 0;
+}
+
+bool Delaunay::is_ghost(int t)
+{
+  return tri[3*t] == INF || tri[3*t+1] == INF || tri[3*t+2] == INF;
+}
+
+int Delaunay::new_triangle(int a, int b, int c)
+{
+  int t;
+
+  if (holes.empty())
+  {
+    t = alive.size();
+    tri.resize(3*t+3);
+    twin.resize(3*t+3);
+    alive.push_back(1);
+    mark.push_back(0);
+  }
+  else
+  {
+    t = holes.back();
+    holes.pop_back();
+    alive[t] = 1;
+  }
+
+  tri[3*t] = a;
+  tri[3*t+1] = b;
+  tri[3*t+2] = c;
+
+  return t;
+}
+
+void Delaunay::delete_triangle(int t)
+{
+  alive[t] = 0;
+  holes.push_back(t);
+}
+
+// > 0 if a, b, c are counterclockwise
+double Delaunay::orient(int a, int b, int c)
+{
+  double left  = (x[b] - x[a]) * (y[c] - y[a]);
+  double right = (y[b] - y[a]) * (x[c] - x[a]);
+  double det = left - right;
+
+  if (std::fabs(det) > ORIENT_ERRBOUND * (std::fabs(left) + std::fabs(right)))
+    return det;
+
+  return orient_exact(x[a], y[a], x[b], y[b], x[c], y[c]);
+}
+
+// > 0 if p is in the circumcircle of the counterclockwise triangle a, b, c
+double Delaunay::incircle(int a, int b, int c, int p)
+{
+  double adx = x[a] - x[p];
+  double ady = y[a] - y[p];
+  double bdx = x[b] - x[p];
+  double bdy = y[b] - y[p];
+  double cdx = x[c] - x[p];
+  double cdy = y[c] - y[p];
+
+  double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+  double cdxady = cdx * ady, adxcdy = adx * cdy;
+  double adxbdy = adx * bdy, bdxady = bdx * ady;
+
+  double ad = adx * adx + ady * ady;
+  double bd = bdx * bdx + bdy * bdy;
+  double cd = cdx * cdx + cdy * cdy;
+
+  double det = ad * (bdxcdy - cdxbdy) + bd * (cdxady - adxcdy) + cd * (adxbdy - bdxady);
+
+  double permanent = (std::fabs(bdxcdy) + std::fabs(cdxbdy)) * ad +
+                     (std::fabs(cdxady) + std::fabs(adxcdy)) * bd +
+                     (std::fabs(adxbdy) + std::fabs(bdxady)) * cd;
+
+  if (std::fabs(det) > INCIRCLE_ERRBOUND * permanent)
+    return det;
+
+  return incircle_exact(x[a], y[a], x[b], y[b], x[c], y[c], x[p], y[p]);
+}
+
+unsigned int Delaunay::rand_next()
+{
+  // xorshift32
+  seed ^= seed << 13;
+  seed ^= seed >> 17;
+  seed ^= seed << 5;
+  return seed;
+}
@@ -0,0 +1,90 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef DELAUNAY_H
+#define DELAUNAY_H
+
+#include <vector>
+#include "Progress.h"
+
+// 2D Delaunay triangulation by incremental insertion (Bowyer-Watson).
+//
+// The points are inserted in a biased randomized order (BRIO): random rounds of increasing
+// sizes, each round being sorted along a Hilbert curve, so each point is located by a short
+// walk from the last triangle created. The triangulation is stored in compact half-edge
+// arrays: edge e of triangle t = e/3 goes from vertex tri[e] to vertex tri[next(e)] and
+// twin[e] is the opposite half-edge. The convex hull is closed with 'ghost' triangles
+// connected to a virtual vertex at infinity so there is no super triangle to remove and the
+// output covers exactly the convex hull. Duplicated points are ignored. The orientation and
+// incircle predicates are filtered: when the floating point result is too small to be
+// trusted the sign is recomputed exactly.
+class Delaunay
+{
+  public:
+    Delaunay(const double* X, const double* Y, int n);
+    ~Delaunay();
+    void triangulate(Progress& progress);
+    int ntriangles();
+    void get_triangles(std::vector<int>& triangles);
+
+  private:
+    static const int MIN_ROUND = 128;             // Size of the first round of insertion
+
+    int npoints;
+    int INF;                                      // Index of the vertex at infinity
+    int last;                                     // Last triangle created (starting point of the walks)
+    unsigned int seed;
+    std::vector<double> x;                        // Coordinates relative to the center of the bbox
+    std::vector<double> y;
+    std::vector<int> tri;                         // 3 vertices per triangle (counterclockwise)
+    std::vector<int> twin;                        // Opposite half-edge of each half-edge
+    std::vector<char> alive;
+    std::vector<int> holes;                       // Slots of the deleted triangles
+    std::vector<int> cavity;
+    std::vector<int> boundary;
+    std::vector<int> mark;                        // Stamp of the current insertion for each triangle
+    std::vector<int> start;                       // New triangle starting at a vertex
+    int stamp;
+
+    static inline int next(int e) { return (e % 3 == 2) ? e - 2 : e + 1; }
+
+    void brio(std::vector<int>& order);
+    bool init(const std::vector<int>& order, int& a, int& b, int& c);
+    bool insert(int p);
+    int locate(int p);
+    bool conflict(int t, int p);
+    bool is_ghost(int t);
+    int new_triangle(int a, int b, int c);
+    void delete_triangle(int t);
+    double orient(int a, int b, int c);
+    double incircle(int a, int b, int c, int p);
+    unsigned int rand_next();
+};
+
+#endif //DELAUNAY_H
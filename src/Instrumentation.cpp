@@ -0,0 +1,172 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+
+#include "Instrumentation.h"
+#include "myomp.h"
+#include <vector>
+
+using namespace Rcpp;
+
+namespace
+{
+  struct Record
+  {
+    int call;
+    std::string label;
+    std::string kernel;
+    std::string stage;
+    double time;
+    double count;
+    double scanned;
+  };
+
+  bool s_enabled = false;
+  int s_call = 0;
+  int s_depth = 0;
+  std::string s_kernel;
+  std::string s_label;
+  std::vector<Record> s_records;
+}
+
+bool instrumentation::enabled()
+{
+  return s_enabled;
+}
+
+// Only the outermost kernel is recorded when a kernel calls another one
+KernelScope::KernelScope(const char* kernel)
+{
+  nested = s_depth > 0;
+  s_depth++;
+
+  if (!s_enabled || nested)
+    return;
+
+  s_call++;
+  s_kernel = kernel;
+}
+
+KernelScope::~KernelScope()
+{
+  s_depth--;
+
+  if (!nested)
+    s_kernel.clear();
+}
+
+Stage::Stage(const char* stage) : on(s_enabled), name(stage), start(0), count(0), scanned(0)
+{
+  if (on)
+    start = omp_get_wtime();
+}
+
+Stage::~Stage()
+{
+  stop();
+}
+
+void Stage::add(double n, double s)
+{
+  count += n;
+  scanned += s;
+}
+
+void Stage::stop()
+{
+  if (!on)
+    return;
+
+  on = false;
+
+  Record r;
+  r.call    = s_call;
+  r.label   = s_label;
+  r.kernel  = s_kernel.empty() ? "unknown" : s_kernel;
+  r.stage   = name;
+  r.time    = omp_get_wtime() - start;
+  r.count   = count;
+  r.scanned = scanned;
+  s_records.push_back(r);
+}
+
+// Enables the instrumentation and clears the previous records
+// [[Rcpp::export]]
+void C_instrumentation_start()
+{
+  s_enabled = true;
+  s_call = 0;
+  s_label.clear();
+  s_records.clear();
+}
+
+// [[Rcpp::export]]
+bool C_instrumentation_enabled()
+{
+  return s_enabled;
+}
+
+// Label attached to the next records, for example the name of the cluster of a catalog
+// [[Rcpp::export]]
+void C_instrumentation_label(std::string label)
+{
+  s_label = label;
+}
+
+// Returns the records as a list of columns (one row per stage of each kernel call) and
+// optionnaly disables the instrumentation.
+// [[Rcpp::export]]
+List C_instrumentation_collect(bool stop = true)
+{
+  int n = s_records.size();
+  IntegerVector call(n);
+  CharacterVector label(n), kernel(n), stage(n);
+  NumericVector time(n), count(n), scanned(n);
+
+  for (int i = 0 ; i < n ; i++)
+  {
+    const Record& r = s_records[i];
+    call[i]    = r.call;
+    label[i]   = r.label;
+    kernel[i]  = r.kernel;
+    stage[i]   = r.stage;
+    time[i]    = r.time;
+    count[i]   = r.count;
+    scanned[i] = r.scanned;
+  }
+
+  if (stop)
+  {
+    s_enabled = false;
+    s_records.clear();
+  }
+
+  return List::create(Named("call") = call, Named("label") = label, Named("kernel") = kernel, Named("stage") = stage,
+                      Named("time") = time, Named("count") = count, Named("scanned") = scanned);
+}
@@ -0,0 +1,74 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <Rcpp.h>
+#include <string>
+
+// Opt-in instrumentation of the native kernels. When it is enabled (see C_instrumentation_start)
+// each kernel call opens a KernelScope and times its main stages (index build, queries, output
+// materialization...) with Stage objects. A stage records its wall time, a count of items (points,
+// queries, cells) and optionally the number of candidate points scanned to answer the queries.
+// When it is disabled a Stage costs a boolean test. The stages must be opened by the master
+// thread outside the parallel regions: the counts of a parallel loop are reduced first.
+class KernelScope
+{
+  public:
+    KernelScope(const char* kernel);
+    ~KernelScope();
+
+  private:
+    bool nested;
+};
+
+class Stage
+{
+  public:
+    Stage(const char* stage);
+    ~Stage();
+    void add(double count, double scanned = 0);
+    void stop();
+
+  private:
+    bool on;
+    const char* name;
+    double start;
+    double count;
+    double scanned;
+};
+
+namespace instrumentation
+{
+  bool enabled();
+}
+
+#endif //INSTRUMENTATION_H
@@ -0,0 +1,169 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include "LASView.h"
+#include <algorithm>
+#include <string>
+
+using namespace Rcpp;
+
+// Orders the points of a view by X, Y then Z
+struct XYZOrder
+{
+  XYZOrder(const double* _x, const double* _y, const double* _z) : x(_x), y(_y), z(_z) {}
+  bool operator()(const int a, const int b) const
+  {
+    if (x[a] != x[b]) return x[a] < x[b];
+    if (y[a] != y[b]) return y[a] < y[b];
+    if (z[a] != z[b]) return z[a] < z[b];
+    return a < b;
+  }
+  const double *x, *y, *z;
+};
+
+LASView::LASView(S4 las)
+{
+  data = as<DataFrame>(las.slot("data"));
+  init();
+}
+
+LASView::LASView(DataFrame _data)
+{
+  data = _data;
+  init();
+}
+
+void LASView::init()
+{
+  if (!has("X") || !has("Y") || !has("Z"))
+    stop("The point cloud must contain the columns X, Y and Z.");
+
+  X = data["X"];
+  Y = data["Y"];
+  Z = data["Z"];
+  npoints = X.length();
+  all = true;
+
+  xs = npoints > 0 ? &X[0] : 0;
+  ys = npoints > 0 ? &Y[0] : 0;
+  zs = npoints > 0 ? &Z[0] : 0;
+}
+
+// Any column of the data.table (in the order of the LAS object, not of the view)
+SEXP LASView::column(const char* column)
+{
+  if (!has(column))
+    stop(std::string("No column '") + column + "' in the point cloud.");
+
+  return data[column];
+}
+
+// Restricts the view to its points such as 'column' equals 'value'. The column can be an
+// integer (e.g. Classification) or a double (e.g. buffer) vector.
+void LASView::select(const char* column, double value)
+{
+  SEXP col = this->column(column);
+  std::vector<int> keep;
+  int n = size();
+
+  if (TYPEOF(col) == INTSXP || TYPEOF(col) == LGLSXP)
+  {
+    IntegerVector v(col);
+    for (int i = 0 ; i < n ; i++)
+      if (v[index(i)] != NA_INTEGER && v[index(i)] == value) keep.push_back(index(i));
+  }
+  else
+  {
+    NumericVector v(col);
+    for (int i = 0 ; i < n ; i++)
+      if (v[index(i)] == value) keep.push_back(index(i));
+  }
+
+  idx.swap(keep);
+  all = false;
+}
+
+// Restricts the view to its points such as mask is TRUE. mask has one element per point of
+// the LAS object, NAs are considered as FALSE.
+void LASView::select(LogicalVector mask)
+{
+  if (mask.length() != npoints)
+    stop("The size of the mask is not the number of points.");
+
+  std::vector<int> keep;
+  int n = size();
+
+  for (int i = 0 ; i < n ; i++)
+    if (mask[index(i)] == TRUE) keep.push_back(index(i));
+
+  idx.swap(keep);
+  all = false;
+}
+
+// Removes the degenerated points of the view with the rules used by the R function
+// interpolate(): the points with same X Y Z coordinates than another point and, among the
+// points with same X Y coordinates, all points but the lowest one. The view is then ordered
+// by X, Y and Z. ndup_xyz and ndup_xy are the numbers of points removed by each rule.
+void LASView::unique_xy(int& ndup_xyz, int& ndup_xy)
+{
+  std::vector<int> order(size());
+
+  for (int i = 0 ; i < size() ; i++)
+    order[i] = index(i);
+
+  std::sort(order.begin(), order.end(), XYZOrder(xs, ys, zs));
+
+  ndup_xyz = 0;
+  ndup_xy  = 0;
+  idx.clear();
+
+  for (unsigned int i = 0 ; i < order.size() ; i++)
+  {
+    int k = order[i];
+
+    if (i > 0)
+    {
+      int l = order[i-1];
+
+      if (X[k] == X[l] && Y[k] == Y[l])
+      {
+        if (Z[k] == Z[l])
+          ndup_xyz++;
+        else
+          ndup_xy++;
+
+        continue;
+      }
+    }
+
+    idx.push_back(k);
+  }
+
+  all = false;
+}
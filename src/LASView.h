@@ -0,0 +1,86 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef LASVIEW_H
+#define LASVIEW_H
+
+#include <Rcpp.h>
+#include <vector>
+
+// Read-only view on the points of a LAS object. The columns are the vectors of the data.table
+// (structure of arrays, no copy) and the view optionally holds the indices of the points it
+// contains, in any order. select() restricts the view to a subset (e.g. Classification == 2 or
+// buffer == 0) so a kernel can work on a subset without R materializing it. Point i of the view
+// is the point index(i) of the LAS object.
+class LASView
+{
+  public:
+    // Column of the view. It has the interface of a vector (size() and operator[]) and can be
+    // given to the templates written for Rcpp vectors such as QuadTreeCreate.
+    struct Column
+    {
+      Column(const double* _values, const int* _index, int _n) : values(_values), index(_index), n(_n) {}
+      int size() const { return n; }
+      double operator[](const int i) const { return index ? values[index[i]] : values[i]; }
+      const double* values;
+      const int* index;
+      int n;
+    };
+
+    LASView(Rcpp::S4 las);
+    LASView(Rcpp::DataFrame data);
+
+    bool has(const char* column) { return data.containsElementNamed(column); }
+    SEXP column(const char* column);
+    void select(const char* column, double value);
+    void select(Rcpp::LogicalVector mask);
+    void unique_xy(int& ndup_xyz, int& ndup_xy);
+
+    int size() const { return all ? npoints : (int)idx.size(); }
+    int index(const int i) const { return all ? i : idx[i]; }
+    Column x() const { return Column(xs, indices(), size()); }
+    Column y() const { return Column(ys, indices(), size()); }
+    Column z() const { return Column(zs, indices(), size()); }
+
+    Rcpp::NumericVector X;
+    Rcpp::NumericVector Y;
+    Rcpp::NumericVector Z;
+
+  private:
+    void init();
+    const int* indices() const { return (all || idx.empty()) ? 0 : &idx[0]; }
+
+    Rcpp::DataFrame data;
+    const double *xs, *ys, *zs;
+    int npoints;
+    bool all;
+    std::vector<int> idx;
+};
+
+#endif //LASVIEW_H
@@ -0,0 +1,378 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include "LiSegmentation.h"
+#include "Instrumentation.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+struct ZSortPointXYZ
+{
+  bool operator()(const PointXYZ& lhs, const PointXYZ& rhs) const { return lhs.z > rhs.z; }
+};
+
+// Points of the groups P and N of the current tree binned in a grid (linked list per cell)
+struct LocalGrid
+{
+  double x0, y0, res;
+  int ncols, nrows;
+  std::vector<int> head;
+  std::vector<int> next;
+  std::vector<double> x, y;
+  std::vector<char> inP;
+
+  void reset(double _x0, double _y0, double _res, int _ncols, int _nrows)
+  {
+    x0 = _x0;
+    y0 = _y0;
+    res = _res;
+    ncols = _ncols;
+    nrows = _nrows;
+    head.assign(ncols*nrows, -1);
+    next.clear();
+    x.clear();
+    y.clear();
+    inP.clear();
+  }
+
+  int col(double px) const { return std::min(std::max((int)std::floor((px - x0) / res), 0), ncols - 1); }
+  int row(double py) const { return std::min(std::max((int)std::floor((py - y0) / res), 0), nrows - 1); }
+
+  void insert(const PointXYZ& p, bool P)
+  {
+    int cell = row(p.y) * ncols + col(p.x);
+    next.push_back(head[cell]);
+    head[cell] = x.size();
+    x.push_back(p.x);
+    y.push_back(p.y);
+    inP.push_back(P);
+  }
+
+  // Minimum square distances from u to P and to N. The cells are visited ring by ring around u.
+  // The search stops when the next rings cannot contain a point closer than min(dP, bound), or
+  // min(dP, dN) if bound_by_N is true. One ring of margin is kept against rounding errors.
+  // Returns the number of points examined.
+  int nearest(const PointXYZ& u, double bound, bool bound_by_N, double& dP, double& dN) const
+  {
+    int ci = col(u.x);
+    int ri = row(u.y);
+    int kmax = std::max(ncols, nrows);
+    int examined = 0;
+
+    for (int k = 0 ; k <= kmax ; k++)
+    {
+      if (k >= 2)
+      {
+        double lb = (k-2)*res;
+        double stop = std::min(dP, bound_by_N ? dN : bound);
+
+        if (lb*lb > stop)
+          break;
+      }
+
+      for (int r = ri - k ; r <= ri + k ; r++)
+      {
+        if (r < 0 || r >= nrows)
+          continue;
+
+        int step = (r == ri - k || r == ri + k) ? 1 : 2*k;
+
+        for (int c = ci - k ; c <= ci + k ; c += step)
+        {
+          if (c < 0 || c >= ncols)
+            continue;
+
+          for (int i = head[r*ncols+c] ; i != -1 ; i = next[i])
+          {
+            double dx = x[i] - u.x;
+            double dy = y[i] - u.y;
+            double d = dx * dx + dy * dy;
+
+            if (inP[i])
+              dP = std::min(dP, d);
+            else
+              dN = std::min(dN, d);
+
+            examined++;
+          }
+        }
+      }
+    }
+
+    return examined;
+  }
+};
+
+LiSegmentation::LiSegmentation(const double* X, const double* Y, const double* Z, int n)
+{
+  npoints = n;
+  ncols = 1;
+  nrows = 1;
+  xmin = 0;
+  ymin = 0;
+  res = 1;
+
+  points.resize(npoints);
+
+  for (int i = 0 ; i < npoints ; i++)
+    points[i] = PointXYZ(X[i], Y[i], Z[i], i);
+
+  std::sort(points.begin(), points.end(), ZSortPointXYZ());
+
+  alive.assign(npoints, true);
+}
+
+LiSegmentation::~LiSegmentation()
+{
+}
+
+int LiSegmentation::col(double x) const
+{
+  int c = (int)std::floor((x - xmin) / res);
+  return std::min(std::max(c, 0), ncols - 1);
+}
+
+int LiSegmentation::row(double y) const
+{
+  int r = (int)std::floor((y - ymin) / res);
+  return std::min(std::max(r, 0), nrows - 1);
+}
+
+// Remaining points within a (squared) radius of u in decreasing Z order. The dead points met
+// in a cell are removed from the cell at the same time. Returns the number of points examined.
+int LiSegmentation::lookup(const PointXYZ& u, double radius, std::vector<int>& neighbours)
+{
+  neighbours.clear();
+  int examined = 0;
+
+  double hw = std::sqrt(radius);
+  int c0 = (hw < std::numeric_limits<double>::infinity()) ? col(u.x - hw) - 1 : 0;
+  int c1 = (hw < std::numeric_limits<double>::infinity()) ? col(u.x + hw) + 1 : ncols - 1;
+  int r0 = (hw < std::numeric_limits<double>::infinity()) ? row(u.y - hw) - 1 : 0;
+  int r1 = (hw < std::numeric_limits<double>::infinity()) ? row(u.y + hw) + 1 : nrows - 1;
+
+  for (int r = std::max(r0, 0) ; r <= std::min(r1, nrows - 1) ; r++)
+  {
+    for (int c = std::max(c0, 0) ; c <= std::min(c1, ncols - 1) ; c++)
+    {
+      int cell = r * ncols + c;
+      int k = offset[cell];
+      examined += end[cell] - offset[cell];
+
+      for (int i = offset[cell] ; i < end[cell] ; i++)
+      {
+        int rank = ranks[i];
+
+        if (!alive[rank])
+          continue;
+
+        ranks[k++] = rank;
+
+        double dx = points[rank].x - u.x;
+        double dy = points[rank].y - u.y;
+
+        if (dx * dx + dy * dy <= radius)
+          neighbours.push_back(rank);
+      }
+
+      end[cell] = k;
+    }
+  }
+
+  std::sort(neighbours.begin(), neighbours.end());
+  return examined;
+}
+
+void LiSegmentation::segment(double dt1, double dt2, double Zu, double th_tree, double radius, const std::vector<bool>& is_lm, bool li2, const PointXYZ& dummy, int* idtree, Progress& progress)
+{
+  if (npoints == 0)
+    return;
+
+  // Square distance to speed up computation (dont need sqrt)
+  double R = radius;
+  radius = radius * radius;
+  dt1 = dt1 * dt1;
+  dt2 = dt2 * dt2;
+
+  // Grid of the remaining points with cells of the size of the search radius. The size of the
+  // cells is increased if needed to get a number of cells of the order of the number of points.
+  Stage index("index");
+  xmin = points[0].x;
+  ymin = points[0].y;
+  double xmax = points[0].x;
+  double ymax = points[0].y;
+
+  for (int i = 1 ; i < npoints ; i++)
+  {
+    xmin = std::min(xmin, points[i].x);
+    ymin = std::min(ymin, points[i].y);
+    xmax = std::max(xmax, points[i].x);
+    ymax = std::max(ymax, points[i].y);
+  }
+
+  double area = std::max(xmax - xmin, 1e-6) * std::max(ymax - ymin, 1e-6);
+  res = std::max(R, std::sqrt(area / (4.0 * npoints)));
+
+  if (!std::isfinite(res))
+    res = std::max(xmax - xmin, ymax - ymin) + 1;
+
+  ncols = (int)((xmax - xmin) / res) + 1;
+  nrows = (int)((ymax - ymin) / res) + 1;
+
+  int ncells = ncols * nrows;
+  std::vector<int> cell(npoints);
+  offset.assign(ncells + 1, 0);
+
+  for (int i = 0 ; i < npoints ; i++)
+  {
+    cell[i] = row(points[i].y) * ncols + col(points[i].x);
+    offset[cell[i]+1]++;
+  }
+
+  for (int c = 0 ; c < ncells ; c++)
+    offset[c+1] += offset[c];
+
+  end.assign(offset.begin(), offset.end() - 1);
+  ranks.resize(npoints);
+
+  for (int i = 0 ; i < npoints ; i++)
+    ranks[end[cell[i]]++] = i;
+
+  std::vector<int>().swap(cell);
+
+  index.add(npoints);
+  index.stop();
+
+  // Size of the cells of the local grid of P and N
+  double lres = std::sqrt(std::max(dt1, dt2));
+
+  /* =====================
+  * LI ET AL ALGORITHHM *
+  ======================*/
+
+  int n = npoints;          // Number of remaining points
+  int k = 1;                // Current tree ID
+  int top = 0;              // Rank of the highest remaining point
+  std::vector<int> neighbours;
+  LocalGrid PN;
+
+  Stage stage("segmentation");
+  double scanned = 0;
+
+  while (n > 0)
+  {
+    while (!alive[top]) top++;
+
+    const PointXYZ& u = points[top];
+
+    // Stop the algo is the highest point u, which is the target tree top, is below a threshold
+    if (u.z < th_tree)
+    {
+      progress.update(npoints);
+      break;
+    }
+
+    if (progress.check_abort())
+      progress.exit();
+
+    progress.update(npoints-n);
+
+    // element 0 is the current highest point and is in P (target tree)
+    alive[top] = false;
+    idtree[u.id] = k;
+    n--;
+
+    // Only the points within the radius can be in the current tree. The others stay in N.
+    scanned += lookup(u, radius, neighbours);
+
+    double bx0 = u.x, bx1 = u.x, by0 = u.y, by1 = u.y;
+
+    for (unsigned int i = 0 ; i < neighbours.size() ; i++)
+    {
+      const PointXYZ& v = points[neighbours[i]];
+      bx0 = std::min(bx0, v.x);
+      bx1 = std::max(bx1, v.x);
+      by0 = std::min(by0, v.y);
+      by1 = std::max(by1, v.y);
+    }
+
+    double ext = std::max(bx1 - bx0, by1 - by0);
+    double cs = lres;
+
+    if (!(cs > 0) || ext / cs > 256)
+      cs = ext / 256;
+
+    if (!(cs > 0))
+      cs = 1;
+
+    PN.reset(bx0, by0, cs, (int)((bx1 - bx0) / cs) + 1, (int)((by1 - by0) / cs) + 1);
+    PN.insert(u, true);
+
+    for (unsigned int i = 0 ; i < neighbours.size() ; i++)
+    {
+      int rank = neighbours[i];
+      const PointXYZ& v = points[rank];
+
+      double dt = (v.z > Zu) ? dt2 : dt1;
+      bool lm = li2 && is_lm[v.id];
+
+      // The dummy point out of the dataset is always in N (see Li et al. page 79)
+      double dx = dummy.x - v.x;
+      double dy = dummy.y - v.y;
+      double dmin1 = std::numeric_limits<double>::infinity();
+      double dmin2 = dx * dx + dy * dy;
+
+      scanned += PN.nearest(v, dt, li2 && !lm, dmin1, dmin2);
+
+      bool inP;
+
+      if (!li2)
+        inP = !((dmin1 > dt) || ((dmin1 <= dt) && (dmin1 > dmin2)));
+      else if (lm)
+        inP = !(dmin1 > dt || (dmin1 < dt && dmin1 > dmin2));
+      else
+        inP = dmin1 <= dmin2;
+
+      PN.insert(v, inP);
+
+      if (inP)
+      {
+        alive[rank] = false;
+        idtree[v.id] = k;
+        n--;
+      }
+    }
+
+    k++;                    // Increase current tree id
+  }
+
+  stage.add(npoints, scanned);
+  return;
+}
@@ -0,0 +1,71 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef LISEGMENTATION_H
+#define LISEGMENTATION_H
+
+#include <vector>
+#include "Point.h"
+#include "Progress.h"
+
+// Individual tree segmentation of Li et al. (2012) on a point cloud.
+//
+// The points are stored once in a contiguous array sorted by decreasing Z and indexed with a
+// regular grid of cells of the size of the search radius. For each tree only the remaining
+// points around the tree top are visited. The points already classified in the groups P and N
+// of the current tree are binned in a small local grid so the minimum distances to P and N are
+// found by looking at the nearby cells only. The segmentation is exactly the same than with a
+// linear search over all the points. segment() records the stages "index" (the grid) and
+// "segmentation" with the number of points examined by the searches (see Instrumentation.h).
+class LiSegmentation
+{
+  public:
+    LiSegmentation(const double* X, const double* Y, const double* Z, int n);
+    ~LiSegmentation();
+    void segment(double dt1, double dt2, double Zu, double th_tree, double radius, const std::vector<bool>& is_lm, bool li2, const PointXYZ& dummy, int* idtree, Progress& progress);
+
+  private:
+    int npoints;
+    int ncols;
+    int nrows;
+    double xmin;
+    double ymin;
+    double res;
+    std::vector<PointXYZ> points;                 // Points sorted by decreasing Z
+    std::vector<char> alive;                      // Points not yet segmented
+    std::vector<int> offset;                      // Rank of the points of cell c are in [offset[c], end[c])
+    std::vector<int> end;
+    std::vector<int> ranks;
+
+    int col(double) const;
+    int row(double) const;
+    int lookup(const PointXYZ& u, double radius, std::vector<int>& neighbours);
+};
+
+#endif //LISEGMENTATION_H
@@ -0,0 +1,82 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+
+#include "LocalMaxima.h"
+#include "myomp.h"
+
+// QuadTree visitor that checks whether a point is the highest of a neighbourhood
+struct WindowMaximum
+{
+  WindowMaximum(const double* _Z, int _i) : Z(_Z), i(_i), zi(_Z[_i]), is_max(true) {}
+
+  void operator()(const Point& pt)
+  {
+    double z = Z[pt.id];
+
+    if (z > zi || (z == zi && pt.id < i))
+      is_max = false;
+  }
+
+  const double* Z;
+  int i;
+  double zi;
+  bool is_max;
+};
+
+double local_maxima_points(QuadTree& tree, const double* X, const double* Y, const double* Z, int n, const double* ws, int nws, bool circular, double min_height, int* lm, int ncpu, const char* skip)
+{
+  double scanned = 0;
+
+  #pragma omp parallel for num_threads(ncpu) reduction(+:scanned)
+  for (int i = 0 ; i < n ; i++)
+  {
+    lm[i] = 0;
+
+    // Also skips NAs
+    if (!(Z[i] > min_height) || (skip != 0 && skip[i]))
+      continue;
+
+    double hws = (nws == 1 ? ws[0] : ws[i]) / 2;
+
+    if (!(hws >= 0))
+      continue;
+
+    WindowMaximum highest(Z, i);
+
+    if (circular)
+      scanned += tree.circle_visit(X[i], Y[i], hws, highest);
+    else
+      scanned += tree.rect_visit(X[i], Y[i], hws, hws, highest);
+
+    lm[i] = highest.is_max;
+  }
+
+  return scanned;
+}
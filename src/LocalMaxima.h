@@ -0,0 +1,48 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef LOCALMAXIMA_H
+#define LOCALMAXIMA_H
+
+#include "QuadTree.h"
+
+// Local maxima of a point cloud indexed by an existing QuadTree built on X Y. A point is a
+// local maximum if it is higher than min_height and if no point of the window centred on it
+// is higher. Within a window the ties are resolved in favour of the point of lowest index so
+// the result does not depend on the order of the lookups nor on the number of threads.
+//
+// The window is a square of size ws or a disc of diameter ws. ws is either a single size
+// (nws = 1) or the size of the window of each point (nws = n), for example computed from the
+// height of the points. lm must have room for n values and receives 1 for the local maxima
+// and 0 otherwise. If skip is given the points such as skip[i] != 0 (e.g. the buffer of a
+// cluster of a catalog) are not tested but are still neighbours of the others. Returns the
+// number of points examined by the lookups.
+double local_maxima_points(QuadTree& tree, const double* X, const double* Y, const double* Z, int n, const double* ws, int nws, bool circular, double min_height, int* lm, int ncpu, const char* skip = 0);
+
+#endif //LOCALMAXIMA_H
@@ -0,0 +1,303 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include "MorphologicalFilter.h"
+#include "myomp.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+struct MinOp
+{
+  static inline double apply(const double a, const double b) { return b < a ? b : a; }
+  static inline double identity() { return std::numeric_limits<double>::infinity(); }
+};
+
+struct MaxOp
+{
+  static inline double apply(const double a, const double b) { return b > a ? b : a; }
+  static inline double identity() { return -std::numeric_limits<double>::infinity(); }
+};
+
+MorphologicalFilter::MorphologicalFilter(const double* X, const double* Y, int n)
+{
+  npoints = n;
+  ncols = 1;
+  nrows = 1;
+  xmin = 0;
+  ymin = 0;
+  res = 1;
+
+  if (npoints > 0)
+  {
+    xmin = *std::min_element(X, X + npoints);
+    ymin = *std::min_element(Y, Y + npoints);
+    double xmax = *std::max_element(X, X + npoints);
+    double ymax = *std::max_element(Y, Y + npoints);
+
+    // Cell size such as each cell contains CELL_POINTS points on average.
+    double area = std::max(xmax - xmin, 1e-6) * std::max(ymax - ymin, 1e-6);
+    res = std::sqrt(CELL_POINTS * area / npoints);
+
+    if (res <= 0 || !std::isfinite(res))
+      res = 1;
+
+    ncols = (int)((xmax - xmin) / res) + 1;
+    nrows = (int)((ymax - ymin) / res) + 1;
+  }
+
+  // Counting sort of the points by cell
+  int ncells = ncols * nrows;
+  std::vector<int> cell(npoints);
+  offset.assign(ncells + 1, 0);
+
+  for (int i = 0 ; i < npoints ; i++)
+  {
+    cell[i] = row(Y[i]) * ncols + col(X[i]);
+    offset[cell[i]+1]++;
+  }
+
+  for (int c = 0 ; c < ncells ; c++)
+    offset[c+1] += offset[c];
+
+  std::vector<int> pos(offset.begin(), offset.end() - 1);
+  index.resize(npoints);
+  x.resize(npoints);
+  y.resize(npoints);
+
+  for (int i = 0 ; i < npoints ; i++)
+  {
+    int k = pos[cell[i]]++;
+    index[k] = i;
+    x[k] = X[i];
+    y[k] = Y[i];
+  }
+}
+
+MorphologicalFilter::~MorphologicalFilter()
+{
+}
+
+int MorphologicalFilter::col(double x) const
+{
+  int c = (int)std::floor((x - xmin) / res);
+  return std::min(std::max(c, 0), ncols - 1);
+}
+
+int MorphologicalFilter::row(double y) const
+{
+  int r = (int)std::floor((y - ymin) / res);
+  return std::min(std::max(r, 0), nrows - 1);
+}
+
+void MorphologicalFilter::erosion(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu)
+{
+  filter<MinOp>(Z, active, ws, Zout, progress, ncpu);
+}
+
+void MorphologicalFilter::dilation(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu)
+{
+  filter<MaxOp>(Z, active, ws, Zout, progress, ncpu);
+}
+
+void MorphologicalFilter::opening(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu)
+{
+  if (npoints == 0)
+    return;
+
+  std::vector<double> Ztemp(npoints);
+  erosion(Z, active, ws, &Ztemp[0], progress, ncpu);
+  dilation(&Ztemp[0], active, ws, Zout, progress, ncpu);
+}
+
+// Applies a van Herk/Gil-Werman running filter of width w along 'count' lines of the grid.
+// Line l holds the n values grid[l*step + i*stride]. After the call grid[l*step + i*stride]
+// is the min (or max) of the w values starting at i, for i <= n-w.
+template<typename Op> void MorphologicalFilter::running_filter(double* grid, int n, int stride, int count, int step, int w, int ncpu)
+{
+  #pragma omp parallel num_threads(ncpu)
+  {
+    std::vector<double> g(n), h(n);
+
+    #pragma omp for
+    for (int l = 0 ; l < count ; l++)
+    {
+      double* line = grid + (size_t)l * step;
+
+      for (int start = 0 ; start < n ; start += w)
+      {
+        int end = std::min(start + w, n);
+
+        g[start] = line[(size_t)start * stride];
+        for (int i = start + 1 ; i < end ; i++)
+          g[i] = Op::apply(g[i-1], line[(size_t)i * stride]);
+
+        h[end-1] = line[(size_t)(end-1) * stride];
+        for (int i = end - 2 ; i >= start ; i--)
+          h[i] = Op::apply(h[i+1], line[(size_t)i * stride]);
+      }
+
+      for (int i = 0 ; i + w <= n ; i++)
+        line[(size_t)i * stride] = Op::apply(h[i], g[i+w-1]);
+    }
+  }
+}
+
+template<typename Op> void MorphologicalFilter::filter(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu)
+{
+  double hws = ws / 2;
+
+  // Z and active flags in the sorted order
+  std::vector<double> z(npoints);
+  std::vector<char> on(npoints);
+
+  for (int k = 0 ; k < npoints ; k++)
+  {
+    z[k] = Z[index[k]];
+    on[k] = active[index[k]];
+  }
+
+  // Minimal number of cells fully covered by a window along one axis. One cell of margin is
+  // kept against rounding, the lookups below are valid for any block of w to 2w cells.
+  int w = (int)std::floor(ws / res) - 2;
+
+  // Min (or max) of each cell followed by the running filters along the rows and the columns.
+  // The grid is padded with empty cells so the windows of the points close to the edges are
+  // handled like the others.
+  int pad = (int)std::ceil(ws / res) + 2;
+  int gcols = ncols + 2 * pad;
+  int grows = nrows + 2 * pad;
+  std::vector<double> grid;
+
+  if (w >= 1)
+  {
+    grid.assign((size_t)gcols * grows, Op::identity());
+
+    for (int r = 0 ; r < nrows ; r++)
+    {
+      for (int cl = 0 ; cl < ncols ; cl++)
+      {
+        int cell = r * ncols + cl;
+        double& g = grid[(size_t)(r + pad) * gcols + (cl + pad)];
+
+        for (int k = offset[cell] ; k < offset[cell+1] ; k++)
+        {
+          if (on[k])
+            g = Op::apply(g, z[k]);
+        }
+      }
+    }
+
+    running_filter<Op>(&grid[0], gcols, 1, grows, gcols, w, ncpu);
+    running_filter<Op>(&grid[0], grows, gcols, gcols, 1, w, ncpu);
+  }
+
+  #pragma omp parallel for num_threads(ncpu)
+  for (int k = 0 ; k < npoints ; k++)
+  {
+    if (!on[k] || progress.check_abort())
+      continue;
+
+    double px = x[k];
+    double py = y[k];
+
+    // Cells containing the edges of the window (may be out of the grid)
+    int c0 = (int)std::floor((px - hws - xmin) / res);
+    int c1 = (int)std::floor((px + hws - xmin) / res);
+    int r0 = (int)std::floor((py - hws - ymin) / res);
+    int r1 = (int)std::floor((py + hws - ymin) / res);
+
+    // Cells strictly between the cells containing the edges of the window: all their points
+    // are in the window whatever the rounding errors. An empty block is encoded with a > b.
+    int a = c0 + 1;
+    int b = c1 - 1;
+    int c = r0 + 1;
+    int d = r1 - 1;
+
+    double val = Op::identity();
+
+    int wx = b - a + 1;
+    int wy = d - c + 1;
+
+    if (w >= 1 && wx >= w && wy >= w && wx <= 2*w && wy <= 2*w)
+    {
+      size_t top = (size_t)(c + pad) * gcols;
+      size_t bottom = (size_t)(d - w + 1 + pad) * gcols;
+      int left = a + pad;
+      int right = b - w + 1 + pad;
+
+      val = Op::apply(val, grid[top + left]);
+      val = Op::apply(val, grid[top + right]);
+      val = Op::apply(val, grid[bottom + left]);
+      val = Op::apply(val, grid[bottom + right]);
+    }
+    else
+    {
+      // No block: all the cells are tested point by point
+      a = 1;
+      b = 0;
+      c = 1;
+      d = 0;
+    }
+
+    // Points of the partially covered cells are tested one by one
+    for (int r = std::max(r0, 0) ; r <= std::min(r1, nrows - 1) ; r++)
+    {
+      bool inner_row = r >= c && r <= d;
+
+      for (int cl = std::max(c0, 0) ; cl <= std::min(c1, ncols - 1) ; cl++)
+      {
+        if (inner_row && cl >= a && cl <= b)
+        {
+          cl = b;
+          continue;
+        }
+
+        int cell = r * ncols + cl;
+
+        for (int i = offset[cell] ; i < offset[cell+1] ; i++)
+        {
+          double dx = px - x[i];
+          double dy = py - y[i];
+          dx = dx < 0 ? -dx : dx;
+          dy = dy < 0 ? -dy : dy;
+
+          if (on[i] && dx <= hws && dy <= hws)
+            val = Op::apply(val, z[i]);
+        }
+      }
+    }
+
+    Zout[index[k]] = val;
+
+    progress.increment();
+  }
+
+  return;
+}
@@ -0,0 +1,74 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef MORPHOLOGICALFILTER_H
+#define MORPHOLOGICALFILTER_H
+
+#include <vector>
+#include "Progress.h"
+
+// Morphological operations on a point cloud with square windows.
+//
+// The points are binned once into a regular grid and stored contiguously cell by cell, so the
+// same layout is reused for any window size and any subset of active points. For each window
+// size the min (or max) of each cell is computed, then the min (or max) over any block of
+// cells is obtained in constant time with van Herk/Gil-Werman running filters along the rows
+// and the columns of the grid. Only the points of the partially covered cells on the border
+// of a window are tested one by one, so the cost per point grows with the perimeter of the
+// window instead of its area. The results are exactly the same than a test of every point.
+class MorphologicalFilter
+{
+  public:
+    MorphologicalFilter(const double* X, const double* Y, int n);
+    ~MorphologicalFilter();
+    void opening(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu);
+    void erosion(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu);
+    void dilation(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu);
+
+  private:
+    static const int CELL_POINTS = 8;             // Average number of points per cell
+
+    int npoints;
+    int ncols;
+    int nrows;
+    double xmin;
+    double ymin;
+    double res;
+    std::vector<int> offset;                      // Points of cell c are in [offset[c], offset[c+1])
+    std::vector<int> index;                       // Original index of each sorted point
+    std::vector<double> x;                        // Coordinates sorted by cell
+    std::vector<double> y;
+
+    int col(double) const;
+    int row(double) const;
+    template<typename Op> void filter(const double* Z, const std::vector<bool>& active, double ws, double* Zout, Progress& progress, int ncpu);
+    template<typename Op> void running_filter(double* grid, int n, int stride, int count, int step, int w, int ncpu);
+};
+
+#endif //MORPHOLOGICALFILTER_H
@@ -0,0 +1,22 @@
+#ifndef OUTPUTVECTOR_H
+#define OUTPUTVECTOR_H
+
+#include <Rcpp.h>
+
+// Output of a kernel. By default (output = NULL) a new vector of size n is allocated. Otherwise
+// output must be a vector of type RTYPE and size n, and the kernel writes directly into its
+// memory without copy. This is how the R side fills a column of a data.table it has just
+// created: the column is updated by reference, so the caller must not pass a vector that is
+// shared with another object nor an input of the kernel.
+template<int RTYPE> Rcpp::Vector<RTYPE> output_vector(SEXP output, int n)
+{
+  if (Rf_isNull(output))
+    return Rcpp::Vector<RTYPE>(n);
+
+  if (TYPEOF(output) != RTYPE || Rf_xlength(output) != n)
+    Rcpp::stop("Internal error: the output vector does not have the expected type or length.");
+
+  return Rcpp::Vector<RTYPE>(output);
+}
+
+#endif //OUTPUTVECTOR_H
@@ -0,0 +1,276 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include "PolygonIndex.h"
+#include <cmath>
+#include <algorithm>
+
+PolygonIndex::PolygonIndex(const std::vector< std::vector<double> >& X, const std::vector< std::vector<double> >& Y)
+{
+  xmin = ymin = 0;
+  xmax = ymax = -1;
+  nslabs = 1;
+  slab_height = 1;
+  ncols = nrows = 1;
+  cell_width = cell_height = 1;
+
+  bool first = true;
+
+  for (size_t r = 0 ; r < X.size() ; r++)
+  {
+    const std::vector<double>& x = X[r];
+    const std::vector<double>& y = Y[r];
+    int nvert = x.size();
+
+    for (int i = 0, j = nvert-1 ; i < nvert ; j = i++)
+    {
+      Edge e = {x[i], y[i], x[j], y[j]};
+      edges.push_back(e);
+
+      if (first)
+      {
+        xmin = xmax = x[i];
+        ymin = ymax = y[i];
+        first = false;
+      }
+
+      if (x[i] < xmin) xmin = x[i];
+      if (x[i] > xmax) xmax = x[i];
+      if (y[i] < ymin) ymin = y[i];
+      if (y[i] > ymax) ymax = y[i];
+    }
+  }
+
+  if (edges.empty())
+    return;
+
+  build_slabs();
+  build_cells();
+}
+
+PolygonIndex::~PolygonIndex()
+{
+}
+
+bool PolygonIndex::contains(double x, double y) const
+{
+  if (x < xmin || x > xmax || y < ymin || y > ymax)
+    return false;
+
+  int c = std::min((int)((x - xmin) / cell_width), ncols - 1);
+  int r = std::min((int)((y - ymin) / cell_height), nrows - 1);
+  char state = cells[r * ncols + c];
+
+  if (state == BOUNDARY)
+    return test(x, y);
+
+  return state == INSIDE;
+}
+
+int PolygonIndex::slab(double y) const
+{
+  int s = (int)std::floor((y - ymin) / slab_height);
+  return std::min(std::max(s, 0), nslabs - 1);
+}
+
+// Counting sort of the edges by slab. An edge can cross a horizontal line at y only if
+// min(y1,y2) < y <= max(y1,y2) so it is recorded in all the slabs between these bounds.
+// An edge spans about nslabs*|dy|/height slabs so the number of slabs is bounded with the
+// sum of the |dy| to keep the number of entries linear with the number of edges, whatever
+// the shape of the polygon (e.g. many long vertical edges).
+void PolygonIndex::build_slabs()
+{
+  int nedges = edges.size();
+  double height = ymax - ymin;
+  double sumdy = 0;
+
+  for (int k = 0 ; k < nedges ; k++)
+    sumdy += std::fabs(edges[k].y2 - edges[k].y1);
+
+  nslabs = std::min(std::max(nedges, 1), (int)MAX_SLABS);
+
+  if (sumdy > 0)
+    nslabs = std::max(std::min((double)nslabs, SLAB_ENTRIES * nedges * height / sumdy), 1.0);
+
+  slab_height = height / nslabs;
+
+  if (slab_height <= 0)
+  {
+    nslabs = 1;
+    slab_height = 1;
+  }
+
+  double total = 0;
+
+  for (int k = 0 ; k < nedges ; k++)
+  {
+    int s0 = slab(std::min(edges[k].y1, edges[k].y2));
+    int s1 = slab(std::max(edges[k].y1, edges[k].y2));
+    total += s1 - s0 + 1;
+  }
+
+  // Should not happen with the bound above. Otherwise go back to a single slab i.e. the
+  // plain ray test against all the edges.
+  if (total > (double)(SLAB_ENTRIES + 2) * nedges)
+  {
+    nslabs = 1;
+    slab_height = std::max(height, 1.0);
+  }
+
+  slab_offset.assign(nslabs + 1, 0);
+
+  for (int k = 0 ; k < nedges ; k++)
+  {
+    int s0 = slab(std::min(edges[k].y1, edges[k].y2));
+    int s1 = slab(std::max(edges[k].y1, edges[k].y2));
+
+    for (int s = s0 ; s <= s1 ; s++)
+      slab_offset[s+1]++;
+  }
+
+  for (int s = 0 ; s < nslabs ; s++)
+    slab_offset[s+1] += slab_offset[s];
+
+  std::vector<int> pos(slab_offset.begin(), slab_offset.end() - 1);
+  slab_edges.resize(slab_offset[nslabs]);
+
+  for (int k = 0 ; k < nedges ; k++)
+  {
+    int s0 = slab(std::min(edges[k].y1, edges[k].y2));
+    int s1 = slab(std::max(edges[k].y1, edges[k].y2));
+
+    for (int s = s0 ; s <= s1 ; s++)
+      slab_edges[pos[s]++] = k;
+  }
+}
+
+// The cells crossed by an edge are flagged as boundary. The other cells get the state of
+// their center. The edges are slightly enlarged so the rounding errors can only flag more
+// cells as boundary.
+void PolygonIndex::build_cells()
+{
+  double w = xmax - xmin;
+  double h = ymax - ymin;
+
+  if (w <= 0 || h <= 0)
+  {
+    ncols = nrows = 1;
+    cell_width = std::max(w, 1.0);
+    cell_height = std::max(h, 1.0);
+    cells.assign(1, BOUNDARY);
+    return;
+  }
+
+  double target = 4.0 * edges.size();
+  ncols = std::min(std::max((int)std::sqrt(target * w / h), 1), (int)MAX_CELLS);
+  nrows = std::min(std::max((int)std::sqrt(target * h / w), 1), (int)MAX_CELLS);
+  cell_width = w / ncols;
+  cell_height = h / nrows;
+
+  cells.assign(ncols * nrows, OUTSIDE);
+
+  double ex = 1e-3 * cell_width;
+  double ey = 1e-3 * cell_height;
+
+  for (size_t k = 0 ; k < edges.size() ; k++)
+  {
+    const Edge& e = edges[k];
+    double ya = std::min(e.y1, e.y2);
+    double yb = std::max(e.y1, e.y2);
+
+    int r0 = std::min(std::max((int)std::floor((ya - ey - ymin) / cell_height), 0), nrows - 1);
+    int r1 = std::min(std::max((int)std::floor((yb + ey - ymin) / cell_height), 0), nrows - 1);
+
+    for (int r = r0 ; r <= r1 ; r++)
+    {
+      // Part of the edge within the (enlarged) row
+      double y0 = std::max(ya, ymin + r * cell_height - ey);
+      double y1 = std::min(yb, ymin + (r + 1) * cell_height + ey);
+      double xa, xb;
+
+      if (yb == ya)
+      {
+        xa = std::min(e.x1, e.x2);
+        xb = std::max(e.x1, e.x2);
+      }
+      else
+      {
+        double u = e.x1 + (e.x2 - e.x1) * (y0 - e.y1) / (e.y2 - e.y1);
+        double v = e.x1 + (e.x2 - e.x1) * (y1 - e.y1) / (e.y2 - e.y1);
+        xa = std::min(u, v);
+        xb = std::max(u, v);
+      }
+
+      int c0 = std::min(std::max((int)std::floor((xa - ex - xmin) / cell_width), 0), ncols - 1);
+      int c1 = std::min(std::max((int)std::floor((xb + ex - xmin) / cell_width), 0), ncols - 1);
+
+      for (int c = c0 ; c <= c1 ; c++)
+        cells[r * ncols + c] = BOUNDARY;
+    }
+  }
+
+  for (int r = 0 ; r < nrows ; r++)
+  {
+    for (int c = 0 ; c < ncols ; c++)
+    {
+      char& state = cells[r * ncols + c];
+
+      if (state != BOUNDARY)
+        state = test(xmin + (c + 0.5) * cell_width, ymin + (r + 0.5) * cell_height) ? INSIDE : OUTSIDE;
+    }
+  }
+}
+
+// Ray casting restricted to the edges of the slab of the point
+bool PolygonIndex::test(double x, double y) const
+{
+  int s = slab(y);
+  bool c = false;
+
+  for (int k = slab_offset[s] ; k < slab_offset[s+1] ; k++)
+  {
+    const Edge& e = edges[slab_edges[k]];
+
+    if (((e.y1 >= y) != (e.y2 >= y)) && (x <= (e.x2 - e.x1) * (y - e.y1) / (e.y2 - e.y1) + e.x1))
+      c = !c;
+  }
+
+  if (!c)
+  {
+    for (int k = slab_offset[s] ; k < slab_offset[s+1] ; k++)
+    {
+      const Edge& e = edges[slab_edges[k]];
+
+      if (e.x1 == x && e.y1 == y)
+        return true;
+    }
+  }
+
+  return c;
+}
@@ -0,0 +1,85 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef POLYGONINDEX_H
+#define POLYGONINDEX_H
+
+#include <vector>
+
+// Point in polygon tests for a polygon made of one or several rings (multi parts and holes).
+// A point is inside if a ray cast from it crosses the edges of all the rings an odd number
+// of times (same test than C_point_in_polygon, W. R. Franklin) so holes and multi parts are
+// handled natively. The points on a vertex are inside.
+//
+// Two indexes are built once per polygon:
+// - a y-slab index: the bbox is split into horizontal slabs and each slab records the edges
+//   that span it, so a point only tests the few edges crossing its own slab.
+// - a coarse raster of the bbox: the cells touched by no edge are entirely inside or outside
+//   the polygon. They are classified once with their center and the points falling in such a
+//   cell are classified without any edge test.
+class PolygonIndex
+{
+  public:
+    PolygonIndex(const std::vector< std::vector<double> >& X, const std::vector< std::vector<double> >& Y);
+    ~PolygonIndex();
+    bool contains(double x, double y) const;
+    double xmin, xmax, ymin, ymax;
+
+  private:
+    struct Edge
+    {
+      double x1, y1, x2, y2;
+    };
+
+    enum CellState { OUTSIDE = 0, INSIDE = 1, BOUNDARY = 2 };
+
+    static const int MAX_SLABS = 1 << 16;
+    static const int SLAB_ENTRIES = 4;            // Target number of slabs spanned by an edge on average
+    static const int MAX_CELLS = 1 << 11;         // Max number of cells along each axis
+
+    std::vector<Edge> edges;
+
+    int nslabs;
+    double slab_height;
+    std::vector<int> slab_offset;                 // Edges of slab s are slab_edges[slab_offset[s]] to slab_edges[slab_offset[s+1]-1]
+    std::vector<int> slab_edges;
+
+    int ncols;
+    int nrows;
+    double cell_width;
+    double cell_height;
+    std::vector<char> cells;
+
+    void build_slabs();
+    void build_cells();
+    int slab(double y) const;
+    bool test(double x, double y) const;
+};
+
+#endif //POLYGONINDEX_H
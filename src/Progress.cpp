@@ -1,22 +1,32 @@
 #include "Progress.h"
+#include "myomp.h"
 
-bool Progress::exist = false;
-
-Progress::Progress(int _iter_max, bool _display)
+Progress::Progress(unsigned int _iter_max, bool _display)
 {
-  if (exist) { Rf_error("Error: there is already an interruptable instance defined"); }
-
   iter_max = _iter_max;
   display = _display;
+  current = 0;
   j = 0;
   percentage = -1;
-  exist = true;
+  abort = false;
 }
 
-Progress::~Progress() { exist = false; }
+Progress::~Progress() {}
 
 bool Progress::check_abort()
 {
+  bool aborted;
+
+  #pragma omp atomic read
+  aborted = abort;
+
+  if (aborted)
+    return true;
+
+  // R API must not be called from any other thread than the master thread
+  if (omp_get_thread_num() != 0)
+    return false;
+
   j++;
 
   if(j % 100 != 0)
@@ -28,15 +38,28 @@ bool Progress::check_abort()
   }
   catch(Rcpp::internal::InterruptedException e)
   {
+    #pragma omp atomic write
+    abort = true;
+
     return true;
   }
 
   return false;
 }
 
-void Progress::update(int iter)
+void Progress::increment()
 {
-  if (!display)
+  unsigned int i;
+
+  #pragma omp atomic capture
+  i = ++current;
+
+  update(i);
+}
+
+void Progress::update(unsigned int iter)
+{
+  if (!display || omp_get_thread_num() != 0)
     return;
 
   int p = (float)iter/(float)iter_max*100;
@@ -54,4 +77,4 @@ void Progress::update(int iter)
 void Progress::exit()
 {
   throw Rcpp::internal::InterruptedException();
-}
\ No newline at end of file
+}
@@ -3,21 +3,28 @@
 
 #include <Rcpp.h>
 
+// Progress bar and user interrupt handler. It can be shared by the threads of an OpenMP
+// parallel loop: every thread can call check_abort() and increment() but only the master
+// thread polls R for a user interrupt and prints the progress. When an interrupt is caught
+// check_abort() returns true in all the threads, which must then skip their work. The loop
+// ends normally and exit() is called after the loop, outside the parallel region.
 class Progress
 {
   public:
-    Progress(int, bool);
+    Progress(unsigned int, bool);
     ~Progress();
     bool check_abort();
-    void update(int);
+    void increment();
+    void update(unsigned int);
     void exit();
 
   private:
-    int iter_max;
+    unsigned int iter_max;
+    unsigned int current;
+    unsigned int j;
     int percentage;
-    int j;
     bool display;
-    static bool exist;
+    bool abort;
 };
 
 #endif //PROGRESS_H
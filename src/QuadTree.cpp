@@ -3,221 +3,450 @@
 #include <limits>
 #include <algorithm>
 #include <iostream>
+#include <queue>
+#include <functional>
+#include <stdexcept>
 
-static inline double max (double a, double b, double c)
+// Spreads the 32 lower bits of v over the even bits of a 64 bits integer
+static inline uint64_t spread_bits(uint64_t v)
 {
-  if (a < b)
-    return (b < c ? c : b);
-  else
-    return (a < c ? c : a);
+  v &= 0x00000000FFFFFFFFULL;
+  v = (v | (v << 16)) & 0x0000FFFF0000FFFFULL;
+  v = (v | (v << 8))  & 0x00FF00FF00FF00FFULL;
+  v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0FULL;
+  v = (v | (v << 2))  & 0x3333333333333333ULL;
+  v = (v | (v << 1))  & 0x5555555555555555ULL;
+  return v;
 }
 
-static inline double min (double a, double b, double c)
+struct MortonKey
 {
-  if (a > b)
-    return (b > c ? c : b);
-  else
-    return (a > c ? c : a);
-}
-
-QuadTree::QuadTree(const double cx, const double cy, const double range)
+  uint64_t code;
+  int idx;
+  bool operator<(const MortonKey& other) const { return code < other.code; }
+};
+
+// If a quantization is given and all the points are on its lattice the points are stored
+// as 32-bit integers once the tree is built.
+QuadTree::QuadTree(std::vector<Point>& pts, const Quantization* q)
 {
-  MAX_DEPTH = 6;
   EPSILON = 0.001;
   EPSILONSQ = EPSILON*EPSILON;
-  npoints = 0;
+  npoints = pts.size();
+  compact = false;
+
+  if (npoints == 0)
+    return;
+
+  double xmin = pts[0].x;
+  double ymin = pts[0].y;
+  double xmax = pts[0].x;
+  double ymax = pts[0].y;
+
+  for(int i = 0 ; i < npoints ; i++)
+  {
+    if(pts[i].x < xmin)
+      xmin = pts[i].x;
+    else if(pts[i].x > xmax)
+      xmax = pts[i].x;
+    if(pts[i].y < ymin)
+      ymin = pts[i].y;
+    else if(pts[i].y > ymax)
+      ymax = pts[i].y;
+  }
+
+  // Morton code of each point in a square grid of 2^MAX_DEPTH x 2^MAX_DEPTH cells
+  double range = xmax - xmin > ymax - ymin ? xmax - xmin : ymax - ymin;
+  double ncells = (double)(1 << MAX_DEPTH);
+  double scale = range > 0 ? (ncells - 1) / range : 0;
+
+  std::vector<MortonKey> keys(npoints);
+
+  for(int i = 0 ; i < npoints ; i++)
+  {
+    uint64_t ix = (uint64_t)((pts[i].x - xmin) * scale);
+    uint64_t iy = (uint64_t)((pts[i].y - ymin) * scale);
+    keys[i].code = spread_bits(ix) | (spread_bits(iy) << 1);
+    keys[i].idx  = i;
+  }
+
+  std::sort(keys.begin(), keys.end());
 
-  boundary = BoundingBox(Point(cx, cy), Point(range, range));
-  depth = 1;
+  // Contiguous storage of the points in Morton order
+  std::vector<uint64_t> codes(npoints);
+  points.resize(npoints);
 
-  NE = 0;
-  NW = 0;
-  SE = 0;
-  SW = 0;
+  for(int i = 0 ; i < npoints ; i++)
+  {
+    codes[i]  = keys[i].code;
+    points[i] = pts[keys[i].idx];
+  }
+
+  std::vector<MortonKey>().swap(keys);
+
+  Node root;
+  root.start = 0;
+  root.end = npoints;
+  nodes.reserve(2 * npoints / LEAF_SIZE + 1);
+  nodes.push_back(root);
+  build(codes, 0, 0);
+
+  if (q != 0 && quantizable(*q))
+  {
+    quant = *q;
+    lattice.resize(npoints);
+
+    for(int i = 0 ; i < npoints ; i++)
+      lattice[i] = encode(points[i], quant);
+
+    std::vector<Point>().swap(points);
+    compact = true;
+  }
 }
 
-QuadTree::QuadTree(const BoundingBox boundary, const QuadTree* parent) : boundary(boundary)
+// Reads a tree written by write(). The nodes are stored as they are in memory, the points
+// either as they are in memory or as 32-bit integers (see Quantization) that are kept as is.
+QuadTree::QuadTree(std::istream& in)
 {
-  MAX_DEPTH = 6;
-  EPSILON = 0.001;
+  int nnodes = 0;
+  int encoding = 0;
+  compact = false;
+  in.read((char*)&EPSILON, sizeof(double));
+  in.read((char*)&npoints, sizeof(int));
+  in.read((char*)&nnodes, sizeof(int));
+  in.read((char*)&encoding, sizeof(int));
+
+  if (!in || npoints < 0 || nnodes < 0 || (encoding != 0 && encoding != 1))
+    throw std::runtime_error("corrupted spatial index");
+
   EPSILONSQ = EPSILON*EPSILON;
-  npoints = 0;
+  nodes.resize(nnodes);
 
-  depth = parent->depth + 1;
+  if (encoding == 0)
+  {
+    points.resize(npoints);
+    if (npoints > 0) in.read((char*)&points[0], sizeof(Point) * npoints);
+  }
+  else
+  {
+    in.read((char*)&quant, sizeof(Quantization));
+    lattice.resize(npoints);
+    if (npoints > 0) in.read((char*)&lattice[0], sizeof(LatticePoint) * npoints);
+    compact = true;
+  }
+
+  if (nnodes > 0)  in.read((char*)&nodes[0], sizeof(Node) * nnodes);
+
+  if (!in || (npoints > 0 && nnodes == 0))
+    throw std::runtime_error("corrupted spatial index");
+
+  for (int i = 0 ; i < npoints ; i++)
+  {
+    int id = compact ? lattice[i].id : points[i].id;
+
+    if (id < 0 || id >= npoints)
+      throw std::runtime_error("corrupted spatial index");
+  }
+
+  // The children are always stored after their parent (see build()) so the tree cannot
+  // contain cycles, and its depth is bounded so the stack of range_visit() cannot overflow.
+  std::vector<int> depth(nnodes, 0);
 
-  NE = 0;
-  NW = 0;
-  SE = 0;
-  SW = 0;
+  for (int i = 0 ; i < nnodes ; i++)
+  {
+    const Node& node = nodes[i];
+
+    if (node.start < 0 || node.end > npoints || node.start > node.end)
+      throw std::runtime_error("corrupted spatial index");
+
+    if (node.child == -1)
+      continue;
+
+    if (node.child <= i || node.nchild < 1 || node.nchild > 4 || node.child > nnodes - node.nchild || depth[i] >= MAX_DEPTH)
+      throw std::runtime_error("corrupted spatial index");
+
+    for (int c = node.child ; c < node.child + node.nchild ; c++)
+      depth[c] = std::max(depth[c], depth[i] + 1);
+  }
 }
 
 QuadTree::~QuadTree()
 {
-  delete NE;
-  delete NW;
-  delete SE;
-  delete SW;
 }
 
-bool QuadTree::insert(const Point& p)
+bool QuadTree::quantized() const
 {
-  if(!boundary.contains(p))
-    return false;
+  return compact;
+}
 
-  npoints++;
+QuadTree::LatticePoint QuadTree::encode(const Point& p, const Quantization& q)
+{
+  LatticePoint l;
+  l.X  = (int32_t)std::floor((p.x - q.xoffset) / q.xscale + 0.5);
+  l.Y  = (int32_t)std::floor((p.y - q.yoffset) / q.yscale + 0.5);
+  l.id = p.id;
+  return l;
+}
+
+// Are all the points exactly on the lattice of the quantization? Always true for points read
+// from a las file with the scale factors and the offsets of its header.
+bool QuadTree::quantizable(const Quantization& q) const
+{
+  if (compact || q.xscale <= 0 || q.yscale <= 0)
+    return false;
 
-  if(depth == MAX_DEPTH)
+  for (int i = 0 ; i < npoints ; i++)
   {
-    points.push_back(p);
-    return true;
-  }
+    double X = std::floor((points[i].x - q.xoffset) / q.xscale + 0.5);
+    double Y = std::floor((points[i].y - q.yoffset) / q.yscale + 0.5);
 
-  if(NW == 0)
-    subdivide();
+    if (X < -2147483648.0 || X > 2147483647.0 || Y < -2147483648.0 || Y > 2147483647.0)
+      return false;
 
-  if(NW->insert(p))
-    return true;
-  if(NE->insert(p))
-    return true;
-  if(SW->insert(p))
-    return true;
-  if(SE->insert(p))
-    return true;
+    if (q.x((int32_t)X) != points[i].x || q.y((int32_t)Y) != points[i].y)
+      return false;
+  }
 
-  return false;
+  return true;
 }
 
-void QuadTree::subdivide()
+// Writes the tree in a binary stream. If a quantization is given and all the points are on its
+// lattice the points are written as 32-bit integers (12 bytes instead of 24 per point) and read
+// back exactly. A compact tree is always written on its own lattice.
+void QuadTree::write(std::ostream& out, const Quantization* q) const
 {
-  double half_res_half = boundary.half_res.x * 0.5;
-
-  Point p(half_res_half+EPSILONSQ, half_res_half+EPSILONSQ);
-  Point pNE(boundary.center.x + half_res_half, boundary.center.y + half_res_half);
-  Point pNW(boundary.center.x - half_res_half, boundary.center.y + half_res_half);
-  Point pSE(boundary.center.x + half_res_half, boundary.center.y - half_res_half);
-  Point pSW(boundary.center.x - half_res_half, boundary.center.y - half_res_half);
-
-  NE = new QuadTree(BoundingBox(pNE, p), this);
-  NW = new QuadTree(BoundingBox(pNW, p), this);
-  SE = new QuadTree(BoundingBox(pSE, p), this);
-  SW = new QuadTree(BoundingBox(pSW, p), this);
+  if (compact)
+    q = &quant;
+
+  int nnodes = nodes.size();
+  int encoding = (q != 0 && (compact || quantizable(*q))) ? 1 : 0;
+  out.write((const char*)&EPSILON, sizeof(double));
+  out.write((const char*)&npoints, sizeof(int));
+  out.write((const char*)&nnodes, sizeof(int));
+  out.write((const char*)&encoding, sizeof(int));
+
+  if (encoding == 0)
+  {
+    if (npoints > 0) out.write((const char*)&points[0], sizeof(Point) * npoints);
+  }
+  else
+  {
+    out.write((const char*)q, sizeof(Quantization));
+
+    if (compact)
+    {
+      if (npoints > 0) out.write((const char*)&lattice[0], sizeof(LatticePoint) * npoints);
+    }
+    else
+    {
+      std::vector<LatticePoint> buffer(IO_BLOCK);
+
+      for (int start = 0 ; start < npoints ; start += IO_BLOCK)
+      {
+        int m = std::min((int)IO_BLOCK, npoints - start);
+
+        for (int k = 0 ; k < m ; k++)
+          buffer[k] = encode(points[start + k], *q);
+
+        out.write((const char*)&buffer[0], sizeof(LatticePoint) * m);
+      }
+    }
+  }
+
+  if (nnodes > 0)  out.write((const char*)&nodes[0], sizeof(Node) * nnodes);
 }
 
-void QuadTree::range_lookup(const BoundingBox bb, std::vector<Point*>& res, const int method)
+// Recursively splits a node into its (up to) four quadrants. Because the points are sorted
+// by Morton code, each quadrant is a contiguous sub-range found by binary search.
+void QuadTree::build(const std::vector<uint64_t>& codes, const int inode, const int depth)
 {
-  if(!boundary.intersects(bb))
-    return;
+  int start = nodes[inode].start;
+  int end = nodes[inode].end;
+
+  nodes[inode].child = -1;
+  nodes[inode].nchild = 0;
 
-  if(depth == MAX_DEPTH)
+  if (end - start <= LEAF_SIZE || depth == MAX_DEPTH)
   {
-    switch(method)
+    double xmin = points[start].x;
+    double ymin = points[start].y;
+    double xmax = points[start].x;
+    double ymax = points[start].y;
+
+    for (int i = start + 1 ; i < end ; i++)
     {
-    case 1: getPointsSquare(bb, points, res);
-      break;
+      if(points[i].x < xmin) xmin = points[i].x;
+      if(points[i].x > xmax) xmax = points[i].x;
+      if(points[i].y < ymin) ymin = points[i].y;
+      if(points[i].y > ymax) ymax = points[i].y;
+    }
 
-    case 2: getPointsCircle(bb, points, res);
-      break;
+    nodes[inode].xmin = xmin;
+    nodes[inode].ymin = ymin;
+    nodes[inode].xmax = xmax;
+    nodes[inode].ymax = ymax;
+    return;
+  }
+
+  int shift = 2 * (MAX_DEPTH - depth - 1);
+  uint64_t prefix = codes[start] & ~((((uint64_t)1) << (shift + 2)) - 1);
+
+  int first = nodes.size();
+  int lower = start;
+
+  for (uint64_t q = 0 ; q < 4 ; q++)
+  {
+    int upper = end;
+
+    if (q < 3)
+      upper = std::lower_bound(codes.begin() + lower, codes.begin() + end, prefix | ((q+1) << shift)) - codes.begin();
+
+    if (upper > lower)
+    {
+      Node child;
+      child.start = lower;
+      child.end = upper;
+      nodes.push_back(child);
     }
+
+    lower = upper;
   }
 
-  if(NW == 0)
-    return;
+  int nchild = nodes.size() - first;
+  nodes[inode].child = first;
+  nodes[inode].nchild = nchild;
 
-  NE->range_lookup(bb, res, method);
-  NW->range_lookup(bb, res, method);
-  SE->range_lookup(bb, res, method);
-  SW->range_lookup(bb, res, method);
+  for (int c = first ; c < first + nchild ; c++)
+    build(codes, c, depth + 1);
 
+  // Bounding box of a node is the union of the bounding boxes of its children
+  Node& node = nodes[inode];
+  node.xmin = nodes[first].xmin;
+  node.ymin = nodes[first].ymin;
+  node.xmax = nodes[first].xmax;
+  node.ymax = nodes[first].ymax;
+
+  for (int c = first + 1 ; c < first + nchild ; c++)
+  {
+    if (nodes[c].xmin < node.xmin) node.xmin = nodes[c].xmin;
+    if (nodes[c].ymin < node.ymin) node.ymin = nodes[c].ymin;
+    if (nodes[c].xmax > node.xmax) node.xmax = nodes[c].xmax;
+    if (nodes[c].ymax > node.ymax) node.ymax = nodes[c].ymax;
+  }
+}
+
+void QuadTree::range_lookup(const BoundingBox bb, std::vector<Point>& res, const int method)
+{
+  PointCollector collector(res);
+  range_visit(bb, collector, method);
   return;
 }
 
-void QuadTree::rect_lookup(const double xc, const double yc, const double half_width, const double half_height, std::vector<Point*>& res)
+void QuadTree::rect_lookup(const double xc, const double yc, const double half_width, const double half_height, std::vector<Point>& res)
 {
   range_lookup(BoundingBox(Point(xc, yc), Point(half_width, half_height)), res, 1);
   return;
 }
 
 
-void QuadTree::circle_lookup(const double cx, const double cy, const double range, std::vector<Point*>& res)
+void QuadTree::circle_lookup(const double cx, const double cy, const double range, std::vector<Point>& res)
 {
   range_lookup(BoundingBox(Point(cx, cy), Point(range, range)), res, 2);
   return;
 }
 
-void QuadTree::triangle_lookup(const Point& A, const Point& B, const Point& C, std::vector<Point*>& res)
+void QuadTree::triangle_lookup(const Point& A, const Point& B, const Point& C, std::vector<Point>& res)
 {
-  // Boundingbox of A B C
-  double rminx = min(A.x, B.x, C.x);
-  double rmaxx = max(A.x, B.x, C.x);
-  double rminy = min(A.y, B.y, C.y);
-  double rmaxy = max(A.y, B.y, C.y);
-
-  double xcenter = (rminx + rmaxx)/2;
-  double ycenter = (rminy + rmaxy)/2;
-  double half_width = (rmaxx - rminx)/2 + EPSILON;
-  double half_height = (rmaxy - rminy )/2 + EPSILON;
-
-  // Boundingbox lookup
-  std::vector<Point*> points;
-  rect_lookup(xcenter, ycenter, half_width, half_height, points);
-
-  // Compute if the points are in A B C
-  for(std::vector<Point*>::iterator it = points.begin(); it != points.end(); it++)
-  {
-    if (in_triangle(**it, A, B, C))
-      res.push_back(*it);
-  }
-
+  PointCollector collector(res);
+  triangle_visit(A, B, C, collector);
   return;
 }
 
-void QuadTree::knn_lookup(const double cx, const double cy, const int k, std::vector<Point*>& res)
+// Best-first k-nearest neighbours search. Nodes are visited by increasing distance to the
+// query point using a priority queue, while the k best candidates found so far are kept in a
+// bounded max-heap. The search stops as soon as the closest unvisited node is farther than
+// the current k-th neighbour.
+int QuadTree::knn_lookup(const double cx, const double cy, const int k, std::vector<Point>& res)
 {
-  double area = 4 * boundary.half_res.x * boundary.half_res.y ; // Dimension of the Quadtree
-  double density = npoints / area;                              // Approx point density
+  if (npoints == 0 || k <= 0)
+    return 0;
+
+  int examined = 0;
 
-  // Radius of the first circle lookup. Computed based on point density to reduce lookup iterations
-  double radius = std::sqrt((double)k / (density * 3.14));
+  std::priority_queue<NodeDistance, std::vector<NodeDistance>, std::greater<NodeDistance> > queue;
+  std::priority_queue<PointDistance> heap;
 
-  Point p(cx, cy);
-  std::vector<Point*> pts;
+  queue.push(NodeDistance(sqdistance_to_node(cx, cy, nodes[0]), 0));
 
-  // Get at least k point within a circle
-  int n = 0;
-  while (n < k)
+  while (!queue.empty())
   {
-    pts.clear();
-    circle_lookup(p.x, p.y, radius, pts);
-    n = pts.size();
-    radius *= 1.5;
-  }
+    NodeDistance nd = queue.top();
+    queue.pop();
 
-  std::sort(pts.begin(), pts.end(), distance_to<Point>(p));
+    if ((int)heap.size() == k && nd.first > heap.top().first)
+      break;
 
-  for (int i = 0 ; i < k ; i++)
-    res.push_back(pts[i]);
+    const Node& node = nodes[nd.second];
 
-  return;
-}
+    if (node.child == -1)
+    {
+      examined += node.end - node.start;
+
+      for (int i = node.start ; i < node.end ; i++)
+      {
+        Point p = point(i);
+        double dx = p.x - cx;
+        double dy = p.y - cy;
+        double d = dx * dx + dy * dy;
+
+        if ((int)heap.size() < k)
+        {
+          heap.push(PointDistance(d, i));
+        }
+        else if (d < heap.top().first)
+        {
+          heap.pop();
+          heap.push(PointDistance(d, i));
+        }
+      }
+    }
+    else
+    {
+      for (int c = node.child ; c < node.child + node.nchild ; c++)
+      {
+        double d = sqdistance_to_node(cx, cy, nodes[c]);
 
-void QuadTree::getPointsSquare(const BoundingBox bb, std::vector<Point>& points, std::vector<Point*>& res)
-{
-  for(std::vector<Point>::iterator it = points.begin(); it != points.end(); it++)
+        if ((int)heap.size() < k || d <= heap.top().first)
+          queue.push(NodeDistance(d, c));
+      }
+    }
+  }
+
+  // The heap pops the farthest point first
+  size_t offset = res.size();
+  res.resize(offset + heap.size());
+
+  for (size_t i = res.size() ; i > offset ; i--)
   {
-    if(in_rect(bb, *it))
-      res.push_back(&(*it));
+    res[i-1] = point(heap.top().second);
+    heap.pop();
   }
-  return;
+
+  return examined;
 }
 
-void QuadTree::getPointsCircle(const BoundingBox bb, std::vector<Point>& points, std::vector<Point*>& res)
+double QuadTree::sqdistance_to_node(const double x, const double y, const Node& node)
 {
-  for(std::vector<Point>::iterator it = points.begin(); it != points.end(); it++)
-  {
-    if(in_circle(bb.center, (*it), bb.half_res.x))
-      res.push_back(&(*it));
-  }
-  return;
+  double dx = 0;
+  double dy = 0;
+
+  if (x < node.xmin) dx = node.xmin - x;
+  else if (x > node.xmax) dx = x - node.xmax;
+
+  if (y < node.ymin) dy = node.ymin - y;
+  else if (y > node.ymax) dy = y - node.ymax;
+
+  return dx * dx + dy * dy;
 }
 
 bool QuadTree::in_circle(const Point& p1, const Point& p2, const double r)
@@ -283,7 +512,13 @@ double QuadTree::distanceSquarePointToSegment(const Point& p1, const Point& p2,
 
 BoundingBox QuadTree::bbox()
 {
-  return this->boundary;
+  if (npoints == 0)
+    return BoundingBox(Point(0, 0), Point(0, 0));
+
+  const Node& root = nodes[0];
+  Point center((root.xmin + root.xmax)/2, (root.ymin + root.ymax)/2);
+  Point half_res((root.xmax - root.xmin)/2, (root.ymax - root.ymin)/2);
+  return BoundingBox(center, half_res);
 }
 
 int QuadTree::count()
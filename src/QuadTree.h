@@ -2,82 +2,259 @@
 #define QT_H
 
 #include <vector>
+#include <utility>
+#include <cmath>
+#include <algorithm>
+#include <stdint.h>
+#include <iosfwd>
 #include "Point.h"
 #include "BoundingBox.h"
 
+// Linear quadtree. The points are sorted once along a Morton (Z-order) curve and stored in
+// a single contiguous array. Each node owns a contiguous range of this array and the nodes
+// are stored in a flat vector (no pointers). A node is subdivided only while it holds more
+// than LEAF_SIZE points so the depth of the tree adapts to the local density of points.
+// The lookups do not modify the tree and can be run concurrently from several threads.
+// If the points are on the lattice of a las header (see Quantization) they are stored as
+// 32-bit integers (12 bytes instead of 24 per point) and decoded exactly on the fly.
 class QuadTree
 {
 	public:
-		QuadTree(const double, const double, const double);
+	  // Scale factors and offsets of the coordinates as in a las header: x = X * xscale + xoffset
+	  struct Quantization
+	  {
+	    double xscale, yscale, xoffset, yoffset;
+	    double x(const int32_t X) const { return X * xscale + xoffset; }
+	    double y(const int32_t Y) const { return Y * yscale + yoffset; }
+	  };
+
+		QuadTree(std::vector<Point>&, const Quantization* = 0);
+		QuadTree(std::istream&);
 	  ~QuadTree();
-		bool insert(const Point&);
-		void rect_lookup(const double, const double, const double, const double, std::vector<Point*>&);
-		void triangle_lookup(const Point&, const Point&, const Point&, std::vector<Point*>&);
-		void circle_lookup(const double, const double, const double, std::vector<Point*>&);
-		void knn_lookup(const double, const double, const int, std::vector<Point*>&);
+		void write(std::ostream&, const Quantization* = 0) const;
+		bool quantized() const;
+		void rect_lookup(const double, const double, const double, const double, std::vector<Point>&);
+		void triangle_lookup(const Point&, const Point&, const Point&, std::vector<Point>&);
+		void circle_lookup(const double, const double, const double, std::vector<Point>&);
+		int knn_lookup(const double, const double, const int, std::vector<Point>&);
+		template<typename Visitor> int rect_visit(const double, const double, const double, const double, Visitor&);
+		template<typename Visitor> int circle_visit(const double, const double, const double, Visitor&);
+		template<typename Visitor> int triangle_visit(const Point&, const Point&, const Point&, Visitor&);
 		int count();
 		BoundingBox bbox();
 
 	private:
-		int MAX_DEPTH;
+	  struct Node
+	  {
+	    double xmin, ymin, xmax, ymax;  // Tight bounding box of the points of the node
+	    int start, end;                 // Range of the node in 'points'
+	    int child;                      // Index of the first child in 'nodes', -1 for a leaf
+	    int nchild;                     // Number of (non empty) children stored contiguously
+	  };
+
+	  // Point on the lattice of a Quantization. Same layout as in the files (see write()).
+	  struct LatticePoint
+	  {
+	    int32_t X, Y;
+	    int id;
+	  };
+
+	  typedef std::pair<double, int> NodeDistance;
+	  typedef std::pair<double, int> PointDistance;
+
+	  static const int LEAF_SIZE = 16;
+	  static const int MAX_DEPTH = 20;
+	  static const int IO_BLOCK = 4096;
+
 	  double EPSILON;
 	  double EPSILONSQ;
-		int depth;
 		int npoints;
-		BoundingBox boundary;
-		std::vector<Point> points;
-		QuadTree* NE;
-		QuadTree* NW;
-		QuadTree* SE;
-		QuadTree* SW;
-		QuadTree* parent;
-		QuadTree(const BoundingBox, const QuadTree*);
-		void subdivide();
-		void range_lookup(const BoundingBox, std::vector<Point*>&, const int);
-		void getPointsSquare(const BoundingBox, std::vector<Point>&, std::vector<Point*>&);
-		void getPointsCircle(const BoundingBox, std::vector<Point>&, std::vector<Point*>&);
+		bool compact;
+		Quantization quant;
+		std::vector<Point> points;         // Points in Morton order, empty if compact
+		std::vector<LatticePoint> lattice; // Same points on the lattice of quant if compact
+		std::vector<Node> nodes;
+		Point point(const int i) const;
+		bool quantizable(const Quantization&) const;
+		static LatticePoint encode(const Point&, const Quantization&);
+		void build(const std::vector<uint64_t>&, const int, const int);
+		void range_lookup(const BoundingBox, std::vector<Point>&, const int);
+		template<typename Visitor> int range_visit(const BoundingBox, Visitor&, const int);
+		template<typename Visitor, typename Storage> int range_visit(const BoundingBox, Visitor&, const int, const Storage&);
+		double sqdistance_to_node(const double, const double, const Node&);
 		bool in_circle(const Point&, const Point&, const double);
 		bool in_rect(const BoundingBox&, const Point&);
 		bool in_triangle(const Point&, const Point&, const Point&, const Point&);
 		double distanceSquarePointToSegment(const Point&, const Point&, const Point&);
+
+		// Accessors of the two storages of the points so the storage is resolved once per query
+		struct DoubleStorage
+		{
+		  DoubleStorage(const Point* _p) : p(_p) {}
+		  Point operator()(const int i) const { return p[i]; }
+		  const Point* p;
+		};
+
+		struct LatticeStorage
+		{
+		  LatticeStorage(const LatticePoint* _p, const Quantization& _q) : p(_p), q(_q) {}
+		  Point operator()(const int i) const { return Point(q.x(p[i].X), q.y(p[i].Y), p[i].id); }
+		  const LatticePoint* p;
+		  const Quantization q;
+		};
+
+		// Visitor that stores a copy of the visited points
+		struct PointCollector
+		{
+		  PointCollector(std::vector<Point>& _res) : res(_res) {}
+		  void operator()(Point& p) { res.push_back(p); }
+		  std::vector<Point>& res;
+		};
+
+		// Visitor that forwards to another visitor only the points that lie in a triangle
+		template<typename Visitor> struct TriangleFilter
+		{
+		  TriangleFilter(QuadTree* _tree, const Point& _A, const Point& _B, const Point& _C, Visitor& _visitor) : tree(_tree), A(_A), B(_B), C(_C), visitor(_visitor) {}
+		  void operator()(Point& p) { if (tree->in_triangle(p, A, B, C)) visitor(p); }
+		  QuadTree* tree;
+		  const Point &A, &B, &C;
+		  Visitor& visitor;
+		};
 };
 
-template<typename T> static QuadTree* QuadTreeCreate(const T x, const T y);
-template<typename T> static QuadTree* QuadTreeCreate(const T x, const T y)
+/* The *_visit() methods are the allocation free counterparts of the *_lookup() methods.
+ * Instead of filling a vector they call visitor(Point&) on each point found, where visitor
+ * is any function object. The caller can thus process the points on the fly, or collect them
+ * into a buffer it owns and reuses from one query to the next. They return the number of points
+ * examined to answer the query (see Instrumentation.h). The point given to the visitor may be
+ * a temporary decoded from the compact storage: the visitor must not keep its address. */
+
+inline Point QuadTree::point(const int i) const
 {
-  int n = x.size();
+  if (!compact)
+    return points[i];
+
+  const LatticePoint& p = lattice[i];
+  return Point(quant.x(p.X), quant.y(p.Y), p.id);
+}
 
-  double xmin = x[0];
-  double ymin = y[0];
-  double xmax = x[0];
-  double ymax = y[0];
+template<typename Visitor> int QuadTree::rect_visit(const double xc, const double yc, const double half_width, const double half_height, Visitor& visitor)
+{
+  return range_visit(BoundingBox(Point(xc, yc), Point(half_width, half_height)), visitor, 1);
+}
 
-  for(int i = 0 ; i < n ; i++)
+template<typename Visitor> int QuadTree::circle_visit(const double cx, const double cy, const double range, Visitor& visitor)
+{
+  return range_visit(BoundingBox(Point(cx, cy), Point(range, range)), visitor, 2);
+}
+
+template<typename Visitor> int QuadTree::triangle_visit(const Point& A, const Point& B, const Point& C, Visitor& visitor)
+{
+  // Boundingbox of A B C
+  double rminx = std::min(A.x, std::min(B.x, C.x));
+  double rmaxx = std::max(A.x, std::max(B.x, C.x));
+  double rminy = std::min(A.y, std::min(B.y, C.y));
+  double rmaxy = std::max(A.y, std::max(B.y, C.y));
+
+  double xcenter = (rminx + rmaxx)/2;
+  double ycenter = (rminy + rmaxy)/2;
+  double half_width = (rmaxx - rminx)/2 + EPSILON;
+  double half_height = (rmaxy - rminy )/2 + EPSILON;
+
+  // Boundingbox lookup and test if the points are in A B C
+  TriangleFilter<Visitor> filter(this, A, B, C, visitor);
+  return rect_visit(xcenter, ycenter, half_width, half_height, filter);
+}
+
+template<typename Visitor> int QuadTree::range_visit(const BoundingBox bb, Visitor& visitor, const int method)
+{
+  if (npoints == 0)
+    return 0;
+
+  if (compact)
+    return range_visit(bb, visitor, method, LatticeStorage(&lattice[0], quant));
+  else
+    return range_visit(bb, visitor, method, DoubleStorage(&points[0]));
+}
+
+template<typename Visitor, typename Storage> int QuadTree::range_visit(const BoundingBox bb, Visitor& visitor, const int method, const Storage& storage)
+{
+  double cx = bb.center.x;
+  double cy = bb.center.y;
+  double hw = bb.half_res.x;
+  double hh = bb.half_res.y;
+
+  // Depth-first traversal with an explicit stack. Each level adds at most 3 nodes.
+  int stack[4*(MAX_DEPTH+1)];
+  int top = 0;
+  int examined = 0;
+  stack[top++] = 0;
+
+  while (top > 0)
   {
-    if(x[i] < xmin)
-      xmin = x[i];
-    else if(x[i] > xmax)
-      xmax = x[i];
-    if(y[i] < ymin)
-      ymin = y[i];
-    else if(y[i] > ymax)
-      ymax = y[i];
+    const Node& node = nodes[stack[--top]];
+
+    // Same arithmetic as in_rect() and in_circle() so the shortcuts below agree with the
+    // point by point tests even for points lying exactly on the edge of the query region
+    if (node.xmin - cx > hw || cx - node.xmax > hw || node.ymin - cy > hh || cy - node.ymax > hh)
+      continue;
+
+    // The node is entirely in the query region: no need to test each point
+    bool inside;
+    double dx = std::max(std::fabs(cx - node.xmin), std::fabs(cx - node.xmax));
+    double dy = std::max(std::fabs(cy - node.ymin), std::fabs(cy - node.ymax));
+
+    if (method == 1)
+      inside = dx <= hw && dy <= hh;
+    else
+      inside = std::sqrt(dx*dx + dy*dy) <= hw;
+
+    if (inside)
+    {
+      for (int i = node.start ; i < node.end ; i++)
+      {
+        Point p = storage(i);
+        visitor(p);
+      }
+
+      examined += node.end - node.start;
+      continue;
+    }
+
+    if (node.child == -1)
+    {
+      examined += node.end - node.start;
+
+      for (int i = node.start ; i < node.end ; i++)
+      {
+        Point p = storage(i);
+        bool in = (method == 1) ? in_rect(bb, p) : in_circle(bb.center, p, hw);
+
+        if (in)
+          visitor(p);
+      }
+
+      continue;
+    }
+
+    for (int c = node.child ; c < node.child + node.nchild ; c++)
+      stack[top++] = c;
   }
 
-  double xrange = xmax - xmin;
-  double yrange = ymax - ymin;
-  double range = xrange > yrange ? xrange/2 : yrange/2;
+  return examined;
+}
+
+template<typename T> static QuadTree* QuadTreeCreate(const T x, const T y, const QuadTree::Quantization* q = 0);
+template<typename T> static QuadTree* QuadTreeCreate(const T x, const T y, const QuadTree::Quantization* q)
+{
+  int n = x.size();
 
-  QuadTree *tree = new QuadTree( (xmin+xmax)/2, (ymin+ymax)/2, range+0.01);
+  std::vector<Point> points(n);
 
   for(int i = 0 ; i < n ; i++)
-  {
-    Point p(x[i], y[i], i);
-    tree->insert(p);
-  }
+    points[i] = Point(x[i], y[i], i);
 
-  return tree;
+  return new QuadTree(points, q);
 }
 
 #endif //QT_H
-
@@ -38,6 +38,7 @@ RasterProcessor::RasterProcessor(NumericMatrix raster, double startx, double sta
   i = 0;
   j = 0;
   m_raster = raster;
+  m_allocated = true;
   m_nrows  = raster.nrow();
   m_ncols  = raster.nrow();
   m_startx = startx;
@@ -53,9 +54,11 @@ RasterProcessor::RasterProcessor(double minx, double miny, double maxx, double m
   i = 0;
   j = 0;
 
+  // The grid starts on the multiple of res below the bounding box so every point of the box
+  // is in a cell (the cell centers are the same than f_grid())
   m_res = res;
-  m_startx = roundany(minx);
-  m_starty = roundany(miny);
+  m_startx = std::floor(minx / res) * res;
+  m_starty = std::floor(miny / res) * res;
   m_xmin   = minx;
   m_ymin   = miny;
 
@@ -65,8 +68,8 @@ RasterProcessor::RasterProcessor(double minx, double miny, double maxx, double m
   m_ncols  = (endx - m_startx) / m_res + 1;
   m_nrows  = (endy - m_starty) / m_res + 1;
 
-  m_raster = NumericMatrix(m_ncols, m_nrows);
-  std::fill(m_raster.begin(), m_raster.end(), NA_REAL);
+  // m_raster is allocated on first use: the layers of PointToRasterProcessor have their own storage
+  m_allocated = false;
 
   /*Rcout << "nrow =  " << m_nrows << " ncol =  " << m_ncols << std::endl;
   Rcout << "startx =  " << m_startx << " starty =  " << m_starty << std::endl;*/
@@ -76,6 +79,16 @@ RasterProcessor::~RasterProcessor()
 {
 }
 
+void RasterProcessor::allocate()
+{
+  if (m_allocated)
+    return;
+
+  m_raster = NumericMatrix(m_ncols, m_nrows);
+  std::fill(m_raster.begin(), m_raster.end(), NA_REAL);
+  m_allocated = true;
+}
+
 void RasterProcessor::xy2ij(double x, double y)
 {
   i = (int)(std::abs((m_startx - x) / m_res) + 1)-1;
@@ -94,6 +107,8 @@ double RasterProcessor::roundany(double x)
 
 List RasterProcessor::expend()
 {
+  allocate();
+
   double x;
   double y;
   std::vector<double> X, Y, Z;
@@ -120,6 +135,7 @@ List RasterProcessor::expend()
 
 NumericMatrix RasterProcessor::getmatrix()
 {
+  allocate();
   return m_raster;
 }
 
@@ -137,6 +153,7 @@ PointToRasterProcessor::~PointToRasterProcessor()
 
 void PointToRasterProcessor::max(double x, double y, double z)
 {
+  allocate();
   xy2ij(x,y);
 
   if (m_raster(i,j) < z || NumericVector::is_na(m_raster(i,j)))
@@ -147,6 +164,7 @@ void PointToRasterProcessor::max(double x, double y, double z)
 
 void PointToRasterProcessor::min(double x, double y, double z)
 {
+  allocate();
   xy2ij(x,y);
 
   if (m_raster(i,j) > z || NumericVector::is_na(m_raster(i,j)))
@@ -157,6 +175,7 @@ void PointToRasterProcessor::min(double x, double y, double z)
 
 void PointToRasterProcessor::count(double x, double y)
 {
+  allocate();
   xy2ij(x,y);
 
   if (NumericVector::is_na(m_raster(i,j)))
@@ -166,3 +185,254 @@ void PointToRasterProcessor::count(double x, double y)
 
   return;
 }
+
+/********************************************
+ *  POINT TO RASTER PROCESSOR: MULTI LAYERS *
+ ********************************************/
+
+// Adds a layer to compute in rasterize(). statistic is one of "max", "min", "count", "sum",
+// "mean" or "sumsq" optionally followed by "_first" to use only the first returns.
+void PointToRasterProcessor::add_layer(std::string statistic, std::string name)
+{
+  Layer layer;
+  layer.name  = name;
+  layer.first = false;
+
+  size_t pos = statistic.rfind("_first");
+
+  if (pos != std::string::npos && pos + 6 == statistic.size())
+  {
+    layer.first = true;
+    statistic = statistic.substr(0, pos);
+  }
+
+  double init = 0;
+
+  if (statistic == "max")
+  {
+    layer.statistic = MAX;
+    init = R_NegInf;
+  }
+  else if (statistic == "min")
+  {
+    layer.statistic = MIN;
+    init = R_PosInf;
+  }
+  else if (statistic == "count")
+    layer.statistic = COUNT;
+  else if (statistic == "sum")
+    layer.statistic = SUM;
+  else if (statistic == "mean")
+    layer.statistic = MEAN;
+  else if (statistic == "sumsq")
+    layer.statistic = SUMSQ;
+  else
+    throw exception(("in add_layer(): unknown statistic " + statistic).c_str());
+
+  int ncells = m_ncols * m_nrows;
+
+  layer.values.assign(ncells, init);
+  m_layers.push_back(layer);
+
+  if (m_count.empty())
+    m_count.assign(ncells, 0);
+
+  if (layer.first && m_count_first.empty())
+    m_count_first.assign(ncells, 0);
+
+  return;
+}
+
+bool PointToRasterProcessor::need_returnnumber()
+{
+  return !m_count_first.empty();
+}
+
+// Same cell than xy2ij() but without exception. Returns -1 for the points out of the grid,
+// with NaN coordinates or out of the core.
+int PointToRasterProcessor::cell(double x, double y)
+{
+  double fx = std::floor((x - m_startx) / m_res);
+  double fy = std::floor((y - m_starty) / m_res);
+
+  if (!(fx >= 0 && fx < m_ncols && fy >= 0 && fy < m_nrows))
+    return -1;
+
+  int ii = (int)fx;
+  int jj = m_nrows - (int)fy - 1;
+
+  if (!m_core_col.empty() && (!m_core_col[ii] || !m_core_row[jj]))
+    return -1;
+
+  return ii + jj * m_ncols;
+}
+
+// Only the cells whose center is in the rectangle are computed and returned. The points of the
+// buffer of a cluster that fall in the other cells are skipped. The cell centers are computed
+// with the same arithmetic than in expend_layers().
+void PointToRasterProcessor::set_core(double xmin, double ymin, double xmax, double ymax)
+{
+  m_core_col.assign(m_ncols, 0);
+  m_core_row.assign(m_nrows, 0);
+
+  for (int ii = 0 ; ii < m_ncols ; ii++)
+  {
+    double x = m_startx + ii * m_res + 0.5 * m_res;
+    m_core_col[ii] = x >= xmin && x <= xmax;
+  }
+
+  for (int jj = 0 ; jj < m_nrows ; jj++)
+  {
+    double y = m_starty + (m_nrows - jj - 1) * m_res + 0.5 * m_res;
+    m_core_row[jj] = y >= ymin && y <= ymax;
+  }
+}
+
+void PointToRasterProcessor::accumulate(int c, double z, bool first)
+{
+  m_count[c]++;
+
+  if (first)
+    m_count_first[c]++;
+
+  for (unsigned int l = 0 ; l < m_layers.size() ; l++)
+  {
+    Layer& layer = m_layers[l];
+
+    if (layer.first && !first)
+      continue;
+
+    double& v = layer.values[c];
+
+    switch(layer.statistic)
+    {
+      case MAX:   v = (z > v) ? z : v; break;
+      case MIN:   v = (z < v) ? z : v; break;
+      case COUNT: v++; break;
+      case SUM:
+      case MEAN:  v += z; break;
+      case SUMSQ: v += z*z; break;
+    }
+  }
+
+  return;
+}
+
+// Computes all the layers in a single pass over the points. The cell of each point is computed
+// once for all the layers. If subcircle > 0 each point is replaced by 8 points on a circle.
+void PointToRasterProcessor::rasterize(NumericVector X, NumericVector Y, NumericVector Z, IntegerVector ReturnNumber, double subcircle)
+{
+  if (m_layers.empty())
+    return;
+
+  bool use_rn = need_returnnumber();
+  int n = X.length();
+
+  if (use_rn && ReturnNumber.length() != n)
+    throw exception("in rasterize(): ReturnNumber is required for first returns statistics.");
+
+  if (subcircle > 0)
+  {
+    double cosa[8], sina[8];
+
+    for (int k = 0 ; k < 8 ; k++)
+    {
+      cosa[k] = subcircle * cos(k*2*PI/8);
+      sina[k] = subcircle * sin(k*2*PI/8);
+    }
+
+    for (int i = 0 ; i < n ; i++)
+    {
+      bool first = use_rn && ReturnNumber[i] == 1;
+
+      for (int k = 0 ; k < 8 ; k++)
+      {
+        int c = cell(X[i] + cosa[k], Y[i] + sina[k]);
+        if (c >= 0) accumulate(c, Z[i], first);
+      }
+    }
+  }
+  else
+  {
+    for (int i = 0 ; i < n ; i++)
+    {
+      bool first = use_rn && ReturnNumber[i] == 1;
+      int c = cell(X[i], Y[i]);
+      if (c >= 0) accumulate(c, Z[i], first);
+    }
+  }
+
+  return;
+}
+
+// Same as expend() with one column per layer. Only the cells that contain at least one point are
+// returned. The statistics of a cell with no point to aggregate are NA (0 for the counts). The
+// NA elevations are ignored by max and min, so a cell with only NA elevations is NA as well.
+List PointToRasterProcessor::expend_layers()
+{
+  int nlayers = m_layers.size();
+  int ncells = 0;
+
+  for (unsigned int c = 0 ; c < m_count.size() ; c++)
+  {
+    if (m_count[c] > 0)
+      ncells++;
+  }
+
+  NumericVector X(ncells), Y(ncells);
+  std::vector<NumericVector> values(nlayers);
+
+  for (int l = 0 ; l < nlayers ; l++)
+    values[l] = NumericVector(ncells);
+
+  int k = 0;
+
+  for (int ii = 0 ; ii < m_ncols ; ii++)
+  {
+    double x = m_startx + ii * m_res + 0.5 * m_res;
+
+    for (int jj = 0 ; jj < m_nrows ; jj++)
+    {
+      int c = ii + jj * m_ncols;
+
+      if (m_count.empty() || m_count[c] == 0)
+        continue;
+
+      X[k] = x;
+      Y[k] = m_starty + (m_nrows - jj - 1) * m_res + 0.5 * m_res;
+
+      for (int l = 0 ; l < nlayers ; l++)
+      {
+        const Layer& layer = m_layers[l];
+        int npts = layer.first ? m_count_first[c] : m_count[c];
+        double v = layer.values[c];
+
+        if (layer.statistic == MEAN)
+          v = (npts > 0) ? v / npts : NA_REAL;
+        else if ((layer.statistic == MAX && (npts == 0 || v == R_NegInf)) || (layer.statistic == MIN && (npts == 0 || v == R_PosInf)))
+          v = NA_REAL;
+
+        values[l][k] = v;
+      }
+
+      k++;
+    }
+  }
+
+  List out(nlayers + 2);
+  CharacterVector names(nlayers + 2);
+
+  out[0] = X;
+  out[1] = Y;
+  names[0] = "X";
+  names[1] = "Y";
+
+  for (int l = 0 ; l < nlayers ; l++)
+  {
+    out[l+2] = values[l];
+    names[l+2] = m_layers[l].name;
+  }
+
+  out.attr("names") = names;
+  return out;
+}
@@ -31,6 +31,8 @@
 #define RASTERPROCESSOR_H
 
 #include <Rcpp.h>
+#include <string>
+#include <vector>
 
 using namespace Rcpp;
 
@@ -54,8 +56,10 @@ class RasterProcessor
     double m_ymin;
     double m_res;
     NumericMatrix m_raster;
+    bool m_allocated;
 
   protected:
+    void allocate();
     void xy2ij(double x, double y);
     double roundany(double x);
 };
@@ -68,6 +72,33 @@ class PointToRasterProcessor : public RasterProcessor
     void max(double x, double y, double z);
     void min(double x, double y, double z);
     void count(double x, double y);
+
+    // Several layers computed in a single pass over the points
+    void add_layer(std::string statistic, std::string name);
+    void rasterize(NumericVector X, NumericVector Y, NumericVector Z, IntegerVector ReturnNumber, double subcircle = 0);
+    void set_core(double xmin, double ymin, double xmax, double ymax);
+    List expend_layers();
+    bool need_returnnumber();
+
+  protected:
+    enum Statistic {MAX, MIN, COUNT, SUM, MEAN, SUMSQ};
+
+    struct Layer
+    {
+      Statistic statistic;
+      bool first;                     // Only the first returns
+      std::string name;
+      std::vector<double> values;
+    };
+
+    std::vector<Layer> m_layers;
+    std::vector<int> m_count;         // Number of points in each cell
+    std::vector<int> m_count_first;   // Number of first returns in each cell
+    std::vector<char> m_core_col;     // Columns and rows in the core of a buffered cluster
+    std::vector<char> m_core_row;
+
+    int cell(double x, double y);
+    void accumulate(int cell, double z, bool first);
 };
 
 #endif //RASTERPROCESSOR_H
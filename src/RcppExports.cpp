@@ -5,22 +5,109 @@
 
 using namespace Rcpp;
 
+// C_delaunay
+IntegerMatrix C_delaunay(NumericVector X, NumericVector Y, bool displaybar);
+RcppExport SEXP _lidR_C_delaunay(SEXP XSEXP, SEXP YSEXP, SEXP displaybarSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< bool >::type displaybar(displaybarSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_delaunay(X, Y, displaybar));
+    return rcpp_result_gen;
+END_RCPP
+}
 // C_grid_canopy
-List C_grid_canopy(S4 las, double res, double subcircle);
-RcppExport SEXP _lidR_C_grid_canopy(SEXP lasSEXP, SEXP resSEXP, SEXP subcircleSEXP) {
+List C_grid_canopy(S4 las, double res, double subcircle, SEXP core);
+RcppExport SEXP _lidR_C_grid_canopy(SEXP lasSEXP, SEXP resSEXP, SEXP subcircleSEXP, SEXP coreSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< S4 >::type las(lasSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< double >::type subcircle(subcircleSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type core(coreSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_grid_canopy(las, res, subcircle, core));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_rasterize
+List C_rasterize(S4 las, double res, CharacterVector stats, CharacterVector names, double subcircle, SEXP core);
+RcppExport SEXP _lidR_C_rasterize(SEXP lasSEXP, SEXP resSEXP, SEXP statsSEXP, SEXP namesSEXP, SEXP subcircleSEXP, SEXP coreSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< S4 >::type las(lasSEXP);
     Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type names(namesSEXP);
     Rcpp::traits::input_parameter< double >::type subcircle(subcircleSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_grid_canopy(las, res, subcircle));
+    Rcpp::traits::input_parameter< SEXP >::type core(coreSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_rasterize(las, res, stats, names, subcircle, core));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_grid_metrics
+List C_grid_metrics(NumericVector X, NumericVector Y, List values, IntegerVector metric, IntegerVector variable, NumericVector param, CharacterVector names, double res, NumericVector start, int ncpu, SEXP core);
+RcppExport SEXP _lidR_C_grid_metrics(SEXP XSEXP, SEXP YSEXP, SEXP valuesSEXP, SEXP metricSEXP, SEXP variableSEXP, SEXP paramSEXP, SEXP namesSEXP, SEXP resSEXP, SEXP startSEXP, SEXP ncpuSEXP, SEXP coreSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< List >::type values(valuesSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type metric(metricSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type variable(variableSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type param(paramSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type names(namesSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type start(startSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type core(coreSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_grid_metrics(X, Y, values, metric, variable, param, names, res, start, ncpu, core));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_voxel_metrics
+List C_voxel_metrics(NumericVector X, NumericVector Y, NumericVector Z, List values, IntegerVector metric, IntegerVector variable, NumericVector param, CharacterVector names, double res, NumericVector start, int ncpu);
+RcppExport SEXP _lidR_C_voxel_metrics(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP valuesSEXP, SEXP metricSEXP, SEXP variableSEXP, SEXP paramSEXP, SEXP namesSEXP, SEXP resSEXP, SEXP startSEXP, SEXP ncpuSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< List >::type values(valuesSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type metric(metricSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type variable(variableSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type param(paramSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type names(namesSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type start(startSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_voxel_metrics(X, Y, Z, values, metric, variable, param, names, res, start, ncpu));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_voxelize
+List C_voxelize(NumericVector X, NumericVector Y, NumericVector Z, double res, NumericVector start);
+RcppExport SEXP _lidR_C_voxelize(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP resSEXP, SEXP startSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type start(startSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_voxelize(X, Y, Z, res, start));
     return rcpp_result_gen;
 END_RCPP
 }
 // C_knn
-Rcpp::List C_knn(NumericVector X, NumericVector Y, NumericVector x, NumericVector y, int k);
-RcppExport SEXP _lidR_C_knn(SEXP XSEXP, SEXP YSEXP, SEXP xSEXP, SEXP ySEXP, SEXP kSEXP) {
+Rcpp::List C_knn(NumericVector X, NumericVector Y, NumericVector x, NumericVector y, int k, int ncpu, SEXP index);
+RcppExport SEXP _lidR_C_knn(SEXP XSEXP, SEXP YSEXP, SEXP xSEXP, SEXP ySEXP, SEXP kSEXP, SEXP ncpuSEXP, SEXP indexSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -29,13 +116,15 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< int >::type k(kSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_knn(X, Y, x, y, k));
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_knn(X, Y, x, y, k, ncpu, index));
     return rcpp_result_gen;
 END_RCPP
 }
 // C_knnidw
-NumericVector C_knnidw(NumericVector X, NumericVector Y, NumericVector Z, NumericVector x, NumericVector y, int k, double p);
-RcppExport SEXP _lidR_C_knnidw(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP xSEXP, SEXP ySEXP, SEXP kSEXP, SEXP pSEXP) {
+NumericVector C_knnidw(NumericVector X, NumericVector Y, NumericVector Z, NumericVector x, NumericVector y, int k, double p, int ncpu, SEXP index);
+RcppExport SEXP _lidR_C_knnidw(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP xSEXP, SEXP ySEXP, SEXP kSEXP, SEXP pSEXP, SEXP ncpuSEXP, SEXP indexSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -46,28 +135,107 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
     Rcpp::traits::input_parameter< int >::type k(kSEXP);
     Rcpp::traits::input_parameter< double >::type p(pSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_knnidw(X, Y, Z, x, y, k, p));
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_knnidw(X, Y, Z, x, y, k, p, ncpu, index));
     return rcpp_result_gen;
 END_RCPP
 }
-// C_lassmooth
-NumericVector C_lassmooth(S4 las, double size, int method, int shape, double sigma);
-RcppExport SEXP _lidR_C_lassmooth(SEXP lasSEXP, SEXP sizeSEXP, SEXP methodSEXP, SEXP shapeSEXP, SEXP sigmaSEXP) {
+// C_knnidw_las
+NumericVector C_knnidw_las(S4 las, NumericVector x, NumericVector y, int k, double p, int classification, int ncpu);
+RcppExport SEXP _lidR_C_knnidw_las(SEXP lasSEXP, SEXP xSEXP, SEXP ySEXP, SEXP kSEXP, SEXP pSEXP, SEXP classificationSEXP, SEXP ncpuSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< S4 >::type las(lasSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type y(ySEXP);
+    Rcpp::traits::input_parameter< int >::type k(kSEXP);
+    Rcpp::traits::input_parameter< double >::type p(pSEXP);
+    Rcpp::traits::input_parameter< int >::type classification(classificationSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_knnidw_las(las, x, y, k, p, classification, ncpu));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_lasfilterdecimate
+IntegerVector C_lasfilterdecimate(NumericVector X, NumericVector Y, double res, int n, NumericVector pulse, bool use_pulse, unsigned int seed, bool homogenize, int ncpu);
+RcppExport SEXP _lidR_C_lasfilterdecimate(SEXP XSEXP, SEXP YSEXP, SEXP resSEXP, SEXP nSEXP, SEXP pulseSEXP, SEXP use_pulseSEXP, SEXP seedSEXP, SEXP homogenizeSEXP, SEXP ncpuSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type pulse(pulseSEXP);
+    Rcpp::traits::input_parameter< bool >::type use_pulse(use_pulseSEXP);
+    Rcpp::traits::input_parameter< unsigned int >::type seed(seedSEXP);
+    Rcpp::traits::input_parameter< bool >::type homogenize(homogenizeSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lasfilterdecimate(X, Y, res, n, pulse, use_pulse, seed, homogenize, ncpu));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_lasfiltersurfacepoints
+IntegerVector C_lasfiltersurfacepoints(NumericVector X, NumericVector Y, NumericVector Z, double res, int ncpu);
+RcppExport SEXP _lidR_C_lasfiltersurfacepoints(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP resSEXP, SEXP ncpuSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lasfiltersurfacepoints(X, Y, Z, res, ncpu));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_lasnormalize
+NumericVector C_lasnormalize(NumericVector X, NumericVector Y, NumericVector Z, NumericMatrix dtm, double xmin, double ymax, double xres, double yres, bool bilinear, int digits, int ncpu);
+RcppExport SEXP _lidR_C_lasnormalize(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP dtmSEXP, SEXP xminSEXP, SEXP ymaxSEXP, SEXP xresSEXP, SEXP yresSEXP, SEXP bilinearSEXP, SEXP digitsSEXP, SEXP ncpuSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< NumericMatrix >::type dtm(dtmSEXP);
+    Rcpp::traits::input_parameter< double >::type xmin(xminSEXP);
+    Rcpp::traits::input_parameter< double >::type ymax(ymaxSEXP);
+    Rcpp::traits::input_parameter< double >::type xres(xresSEXP);
+    Rcpp::traits::input_parameter< double >::type yres(yresSEXP);
+    Rcpp::traits::input_parameter< bool >::type bilinear(bilinearSEXP);
+    Rcpp::traits::input_parameter< int >::type digits(digitsSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lasnormalize(X, Y, Z, dtm, xmin, ymax, xres, yres, bilinear, digits, ncpu));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_lassmooth
+NumericVector C_lassmooth(NumericVector X, NumericVector Y, NumericVector Z, double size, int method, int shape, double sigma, int ncpu, SEXP output, SEXP index);
+RcppExport SEXP _lidR_C_lassmooth(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP sizeSEXP, SEXP methodSEXP, SEXP shapeSEXP, SEXP sigmaSEXP, SEXP ncpuSEXP, SEXP outputSEXP, SEXP indexSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
     Rcpp::traits::input_parameter< double >::type size(sizeSEXP);
     Rcpp::traits::input_parameter< int >::type method(methodSEXP);
     Rcpp::traits::input_parameter< int >::type shape(shapeSEXP);
     Rcpp::traits::input_parameter< double >::type sigma(sigmaSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_lassmooth(las, size, method, shape, sigma));
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type output(outputSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lassmooth(X, Y, Z, size, method, shape, sigma, ncpu, output, index));
     return rcpp_result_gen;
 END_RCPP
 }
 // C_lastrees_li2
-IntegerVector C_lastrees_li2(S4 las, double dt1, double dt2, double Zu, double R, double th_tree, double radius, bool progressbar);
-RcppExport SEXP _lidR_C_lastrees_li2(SEXP lasSEXP, SEXP dt1SEXP, SEXP dt2SEXP, SEXP ZuSEXP, SEXP RSEXP, SEXP th_treeSEXP, SEXP radiusSEXP, SEXP progressbarSEXP) {
+IntegerVector C_lastrees_li2(S4 las, double dt1, double dt2, double Zu, double R, double th_tree, double radius, bool progressbar, SEXP output, SEXP index);
+RcppExport SEXP _lidR_C_lastrees_li2(SEXP lasSEXP, SEXP dt1SEXP, SEXP dt2SEXP, SEXP ZuSEXP, SEXP RSEXP, SEXP th_treeSEXP, SEXP radiusSEXP, SEXP progressbarSEXP, SEXP outputSEXP, SEXP indexSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -79,7 +247,9 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type th_tree(th_treeSEXP);
     Rcpp::traits::input_parameter< double >::type radius(radiusSEXP);
     Rcpp::traits::input_parameter< bool >::type progressbar(progressbarSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_lastrees_li2(las, dt1, dt2, Zu, R, th_tree, radius, progressbar));
+    Rcpp::traits::input_parameter< SEXP >::type output(outputSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lastrees_li2(las, dt1, dt2, Zu, R, th_tree, radius, progressbar, output, index));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -100,8 +270,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // C_lastrees_li
-IntegerVector C_lastrees_li(S4 las, double dt1, double dt2, double Zu, double th_tree, double R, bool progressbar);
-RcppExport SEXP _lidR_C_lastrees_li(SEXP lasSEXP, SEXP dt1SEXP, SEXP dt2SEXP, SEXP ZuSEXP, SEXP th_treeSEXP, SEXP RSEXP, SEXP progressbarSEXP) {
+IntegerVector C_lastrees_li(S4 las, double dt1, double dt2, double Zu, double th_tree, double R, bool progressbar, SEXP output);
+RcppExport SEXP _lidR_C_lastrees_li(SEXP lasSEXP, SEXP dt1SEXP, SEXP dt2SEXP, SEXP ZuSEXP, SEXP th_treeSEXP, SEXP RSEXP, SEXP progressbarSEXP, SEXP outputSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -112,7 +282,41 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< double >::type th_tree(th_treeSEXP);
     Rcpp::traits::input_parameter< double >::type R(RSEXP);
     Rcpp::traits::input_parameter< bool >::type progressbar(progressbarSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_lastrees_li(las, dt1, dt2, Zu, th_tree, R, progressbar));
+    Rcpp::traits::input_parameter< SEXP >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lastrees_li(las, dt1, dt2, Zu, th_tree, R, progressbar, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_lastrees_silva
+IntegerMatrix C_lastrees_silva(NumericMatrix Image, double xmin, double ymin, double res, NumericVector ttx, NumericVector tty, double max_cr_factor, double exclusion, int ncpu);
+RcppExport SEXP _lidR_C_lastrees_silva(SEXP ImageSEXP, SEXP xminSEXP, SEXP yminSEXP, SEXP resSEXP, SEXP ttxSEXP, SEXP ttySEXP, SEXP max_cr_factorSEXP, SEXP exclusionSEXP, SEXP ncpuSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type Image(ImageSEXP);
+    Rcpp::traits::input_parameter< double >::type xmin(xminSEXP);
+    Rcpp::traits::input_parameter< double >::type ymin(yminSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ttx(ttxSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type tty(ttySEXP);
+    Rcpp::traits::input_parameter< double >::type max_cr_factor(max_cr_factorSEXP);
+    Rcpp::traits::input_parameter< double >::type exclusion(exclusionSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lastrees_silva(Image, xmin, ymin, res, ttx, tty, max_cr_factor, exclusion, ncpu));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_lastrees_watershed
+IntegerMatrix C_lastrees_watershed(NumericMatrix Image, IntegerMatrix Seeds, double th_tree, double precision);
+RcppExport SEXP _lidR_C_lastrees_watershed(SEXP ImageSEXP, SEXP SeedsSEXP, SEXP th_treeSEXP, SEXP precisionSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericMatrix >::type Image(ImageSEXP);
+    Rcpp::traits::input_parameter< IntegerMatrix >::type Seeds(SeedsSEXP);
+    Rcpp::traits::input_parameter< double >::type th_tree(th_treeSEXP);
+    Rcpp::traits::input_parameter< double >::type precision(precisionSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_lastrees_watershed(Image, Seeds, th_tree, precision));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -128,34 +332,41 @@ BEGIN_RCPP
 END_RCPP
 }
 // C_LocalMaximaMatrix
-IntegerMatrix C_LocalMaximaMatrix(NumericMatrix image, int ws, double th);
-RcppExport SEXP _lidR_C_LocalMaximaMatrix(SEXP imageSEXP, SEXP wsSEXP, SEXP thSEXP) {
+IntegerMatrix C_LocalMaximaMatrix(NumericMatrix image, IntegerVector ws, double th, int ncpu);
+RcppExport SEXP _lidR_C_LocalMaximaMatrix(SEXP imageSEXP, SEXP wsSEXP, SEXP thSEXP, SEXP ncpuSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericMatrix >::type image(imageSEXP);
-    Rcpp::traits::input_parameter< int >::type ws(wsSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type ws(wsSEXP);
     Rcpp::traits::input_parameter< double >::type th(thSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_LocalMaximaMatrix(image, ws, th));
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_LocalMaximaMatrix(image, ws, th, ncpu));
     return rcpp_result_gen;
 END_RCPP
 }
 // C_LocalMaximaPoints
-LogicalVector C_LocalMaximaPoints(S4 las, double ws, double min_height);
-RcppExport SEXP _lidR_C_LocalMaximaPoints(SEXP lasSEXP, SEXP wsSEXP, SEXP min_heightSEXP) {
+LogicalVector C_LocalMaximaPoints(NumericVector X, NumericVector Y, NumericVector Z, NumericVector ws, double min_height, bool circular, int ncpu, SEXP index, SEXP buffer);
+RcppExport SEXP _lidR_C_LocalMaximaPoints(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP wsSEXP, SEXP min_heightSEXP, SEXP circularSEXP, SEXP ncpuSEXP, SEXP indexSEXP, SEXP bufferSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< S4 >::type las(lasSEXP);
-    Rcpp::traits::input_parameter< double >::type ws(wsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ws(wsSEXP);
     Rcpp::traits::input_parameter< double >::type min_height(min_heightSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_LocalMaximaPoints(las, ws, min_height));
+    Rcpp::traits::input_parameter< bool >::type circular(circularSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type buffer(bufferSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_LocalMaximaPoints(X, Y, Z, ws, min_height, circular, ncpu, index, buffer));
     return rcpp_result_gen;
 END_RCPP
 }
 // C_MorphologicalOpening
-NumericVector C_MorphologicalOpening(NumericVector X, NumericVector Y, NumericVector Z, double resolution, bool displaybar);
-RcppExport SEXP _lidR_C_MorphologicalOpening(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP resolutionSEXP, SEXP displaybarSEXP) {
+NumericVector C_MorphologicalOpening(NumericVector X, NumericVector Y, NumericVector Z, double resolution, bool displaybar, int ncpu, SEXP output);
+RcppExport SEXP _lidR_C_MorphologicalOpening(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP resolutionSEXP, SEXP displaybarSEXP, SEXP ncpuSEXP, SEXP outputSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -164,7 +375,26 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
     Rcpp::traits::input_parameter< double >::type resolution(resolutionSEXP);
     Rcpp::traits::input_parameter< bool >::type displaybar(displaybarSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_MorphologicalOpening(X, Y, Z, resolution, displaybar));
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type output(outputSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_MorphologicalOpening(X, Y, Z, resolution, displaybar, ncpu, output));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_ProgressiveMorphologicalFilter
+LogicalVector C_ProgressiveMorphologicalFilter(NumericVector X, NumericVector Y, NumericVector Z, NumericVector ws, NumericVector th, bool displaybar, int ncpu);
+RcppExport SEXP _lidR_C_ProgressiveMorphologicalFilter(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP wsSEXP, SEXP thSEXP, SEXP displaybarSEXP, SEXP ncpuSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type ws(wsSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type th(thSEXP);
+    Rcpp::traits::input_parameter< bool >::type displaybar(displaybarSEXP);
+    Rcpp::traits::input_parameter< int >::type ncpu(ncpuSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_ProgressiveMorphologicalFilter(X, Y, Z, ws, th, displaybar, ncpu));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -197,8 +427,8 @@ BEGIN_RCPP
 END_RCPP
 }
 // C_points_in_polygons
-IntegerVector C_points_in_polygons(Rcpp::List vertx, Rcpp::List verty, NumericVector pointx, NumericVector pointy, bool displaybar);
-RcppExport SEXP _lidR_C_points_in_polygons(SEXP vertxSEXP, SEXP vertySEXP, SEXP pointxSEXP, SEXP pointySEXP, SEXP displaybarSEXP) {
+IntegerVector C_points_in_polygons(Rcpp::List vertx, Rcpp::List verty, NumericVector pointx, NumericVector pointy, bool displaybar, SEXP index);
+RcppExport SEXP _lidR_C_points_in_polygons(SEXP vertxSEXP, SEXP vertySEXP, SEXP pointxSEXP, SEXP pointySEXP, SEXP displaybarSEXP, SEXP indexSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -207,7 +437,51 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< NumericVector >::type pointx(pointxSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type pointy(pointySEXP);
     Rcpp::traits::input_parameter< bool >::type displaybar(displaybarSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_points_in_polygons(vertx, verty, pointx, pointy, displaybar));
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_points_in_polygons(vertx, verty, pointx, pointy, displaybar, index));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_raster_stream_create
+SEXP C_raster_stream_create(double xmin, double ymin, double xmax, double ymax, double res, CharacterVector stats, CharacterVector names);
+RcppExport SEXP _lidR_C_raster_stream_create(SEXP xminSEXP, SEXP yminSEXP, SEXP xmaxSEXP, SEXP ymaxSEXP, SEXP resSEXP, SEXP statsSEXP, SEXP namesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< double >::type xmin(xminSEXP);
+    Rcpp::traits::input_parameter< double >::type ymin(yminSEXP);
+    Rcpp::traits::input_parameter< double >::type xmax(xmaxSEXP);
+    Rcpp::traits::input_parameter< double >::type ymax(ymaxSEXP);
+    Rcpp::traits::input_parameter< double >::type res(resSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type stats(statsSEXP);
+    Rcpp::traits::input_parameter< CharacterVector >::type names(namesSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_raster_stream_create(xmin, ymin, xmax, ymax, res, stats, names));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_raster_stream_update
+void C_raster_stream_update(SEXP stream, NumericVector X, NumericVector Y, NumericVector Z, IntegerVector ReturnNumber, double subcircle);
+RcppExport SEXP _lidR_C_raster_stream_update(SEXP streamSEXP, SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP ReturnNumberSEXP, SEXP subcircleSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type stream(streamSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< IntegerVector >::type ReturnNumber(ReturnNumberSEXP);
+    Rcpp::traits::input_parameter< double >::type subcircle(subcircleSEXP);
+    C_raster_stream_update(stream, X, Y, Z, ReturnNumber, subcircle);
+    return R_NilValue;
+END_RCPP
+}
+// C_raster_stream_values
+List C_raster_stream_values(SEXP stream);
+RcppExport SEXP _lidR_C_raster_stream_values(SEXP streamSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type stream(streamSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_raster_stream_values(stream));
     return rcpp_result_gen;
 END_RCPP
 }
@@ -224,41 +498,56 @@ BEGIN_RCPP
 END_RCPP
 }
 // fast_countequal
-int fast_countequal(NumericVector x, double t);
+int fast_countequal(SEXP x, double t);
 RcppExport SEXP _lidR_fast_countequal(SEXP xSEXP, SEXP tSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< double >::type t(tSEXP);
     rcpp_result_gen = Rcpp::wrap(fast_countequal(x, t));
     return rcpp_result_gen;
 END_RCPP
 }
 // fast_countbelow
-int fast_countbelow(NumericVector x, double t);
+int fast_countbelow(SEXP x, double t);
 RcppExport SEXP _lidR_fast_countbelow(SEXP xSEXP, SEXP tSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< double >::type t(tSEXP);
     rcpp_result_gen = Rcpp::wrap(fast_countbelow(x, t));
     return rcpp_result_gen;
 END_RCPP
 }
 // fast_countover
-int fast_countover(NumericVector x, double t);
+int fast_countover(SEXP x, double t);
 RcppExport SEXP _lidR_fast_countover(SEXP xSEXP, SEXP tSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
-    Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
     Rcpp::traits::input_parameter< double >::type t(tSEXP);
     rcpp_result_gen = Rcpp::wrap(fast_countover(x, t));
     return rcpp_result_gen;
 END_RCPP
 }
+// fast_summary
+List fast_summary(SEXP x, NumericVector equal, NumericVector below, NumericVector over, NumericVector breaks);
+RcppExport SEXP _lidR_fast_summary(SEXP xSEXP, SEXP equalSEXP, SEXP belowSEXP, SEXP overSEXP, SEXP breaksSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type x(xSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type equal(equalSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type below(belowSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type over(overSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type breaks(breaksSEXP);
+    rcpp_result_gen = Rcpp::wrap(fast_summary(x, equal, below, over, breaks));
+    return rcpp_result_gen;
+END_RCPP
+}
 // fast_extract
 NumericVector fast_extract(NumericMatrix r, NumericVector x, NumericVector y, double xmin, double ymin, double res);
 RcppExport SEXP _lidR_fast_extract(SEXP rSEXP, SEXP xSEXP, SEXP ySEXP, SEXP xminSEXP, SEXP yminSEXP, SEXP resSEXP) {
@@ -276,32 +565,83 @@ BEGIN_RCPP
 END_RCPP
 }
 // roundc
-NumericVector roundc(NumericVector x, int digit);
-RcppExport SEXP _lidR_roundc(SEXP xSEXP, SEXP digitSEXP) {
+NumericVector roundc(NumericVector x, int digit, bool inplace);
+RcppExport SEXP _lidR_roundc(SEXP xSEXP, SEXP digitSEXP, SEXP inplaceSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< NumericVector >::type x(xSEXP);
     Rcpp::traits::input_parameter< int >::type digit(digitSEXP);
-    rcpp_result_gen = Rcpp::wrap(roundc(x, digit));
+    Rcpp::traits::input_parameter< bool >::type inplace(inplaceSEXP);
+    rcpp_result_gen = Rcpp::wrap(roundc(x, digit, inplace));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_index_build
+SEXP C_index_build(NumericVector X, NumericVector Y, SEXP quantization);
+RcppExport SEXP _lidR_C_index_build(SEXP XSEXP, SEXP YSEXP, SEXP quantizationSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type quantization(quantizationSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_index_build(X, Y, quantization));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_index_valid
+bool C_index_valid(SEXP index, NumericVector X, NumericVector Y);
+RcppExport SEXP _lidR_C_index_valid(SEXP indexSEXP, SEXP XSEXP, SEXP YSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_index_valid(index, X, Y));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_index_write
+void C_index_write(SEXP index, std::string file, SEXP quantization);
+RcppExport SEXP _lidR_C_index_write(SEXP indexSEXP, SEXP fileSEXP, SEXP quantizationSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type quantization(quantizationSEXP);
+    C_index_write(index, file, quantization);
+    return R_NilValue;
+END_RCPP
+}
+// C_index_read
+SEXP C_index_read(std::string file);
+RcppExport SEXP _lidR_C_index_read(SEXP fileSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type file(fileSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_index_read(file));
     return rcpp_result_gen;
 END_RCPP
 }
 // C_tinfo
-NumericMatrix C_tinfo(IntegerMatrix M, NumericMatrix X);
-RcppExport SEXP _lidR_C_tinfo(SEXP MSEXP, SEXP XSEXP) {
+NumericMatrix C_tinfo(IntegerMatrix M, NumericMatrix X, SEXP columns);
+RcppExport SEXP _lidR_C_tinfo(SEXP MSEXP, SEXP XSEXP, SEXP columnsSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< IntegerMatrix >::type M(MSEXP);
     Rcpp::traits::input_parameter< NumericMatrix >::type X(XSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_tinfo(M, X));
+    Rcpp::traits::input_parameter< SEXP >::type columns(columnsSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_tinfo(M, X, columns));
     return rcpp_result_gen;
 END_RCPP
 }
 // C_tsearch
-IntegerVector C_tsearch(NumericVector x, NumericVector y, IntegerMatrix elem, NumericVector xi, NumericVector yi, bool diplaybar);
-RcppExport SEXP _lidR_C_tsearch(SEXP xSEXP, SEXP ySEXP, SEXP elemSEXP, SEXP xiSEXP, SEXP yiSEXP, SEXP diplaybarSEXP) {
+IntegerVector C_tsearch(NumericVector x, NumericVector y, IntegerMatrix elem, NumericVector xi, NumericVector yi, bool diplaybar, SEXP index);
+RcppExport SEXP _lidR_C_tsearch(SEXP xSEXP, SEXP ySEXP, SEXP elemSEXP, SEXP xiSEXP, SEXP yiSEXP, SEXP diplaybarSEXP, SEXP indexSEXP) {
 BEGIN_RCPP
     Rcpp::RObject rcpp_result_gen;
     Rcpp::RNGScope rcpp_rngScope_gen;
@@ -311,34 +651,119 @@ BEGIN_RCPP
     Rcpp::traits::input_parameter< NumericVector >::type xi(xiSEXP);
     Rcpp::traits::input_parameter< NumericVector >::type yi(yiSEXP);
     Rcpp::traits::input_parameter< bool >::type diplaybar(diplaybarSEXP);
-    rcpp_result_gen = Rcpp::wrap(C_tsearch(x, y, elem, xi, yi, diplaybar));
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_tsearch(x, y, elem, xi, yi, diplaybar, index));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_tinterpolate
+NumericVector C_tinterpolate(NumericVector X, NumericVector Y, NumericVector Z, IntegerMatrix D, NumericVector xi, NumericVector yi, double maxedge, bool displaybar, SEXP index);
+RcppExport SEXP _lidR_C_tinterpolate(SEXP XSEXP, SEXP YSEXP, SEXP ZSEXP, SEXP DSEXP, SEXP xiSEXP, SEXP yiSEXP, SEXP maxedgeSEXP, SEXP displaybarSEXP, SEXP indexSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< NumericVector >::type X(XSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Y(YSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type Z(ZSEXP);
+    Rcpp::traits::input_parameter< IntegerMatrix >::type D(DSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type xi(xiSEXP);
+    Rcpp::traits::input_parameter< NumericVector >::type yi(yiSEXP);
+    Rcpp::traits::input_parameter< double >::type maxedge(maxedgeSEXP);
+    Rcpp::traits::input_parameter< bool >::type displaybar(displaybarSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type index(indexSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_tinterpolate(X, Y, Z, D, xi, yi, maxedge, displaybar, index));
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_instrumentation_start
+void C_instrumentation_start();
+RcppExport SEXP _lidR_C_instrumentation_start() {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    C_instrumentation_start();
+    return R_NilValue;
+END_RCPP
+}
+// C_instrumentation_enabled
+bool C_instrumentation_enabled();
+RcppExport SEXP _lidR_C_instrumentation_enabled() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(C_instrumentation_enabled());
+    return rcpp_result_gen;
+END_RCPP
+}
+// C_instrumentation_label
+void C_instrumentation_label(std::string label);
+RcppExport SEXP _lidR_C_instrumentation_label(SEXP labelSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type label(labelSEXP);
+    C_instrumentation_label(label);
+    return R_NilValue;
+END_RCPP
+}
+// C_instrumentation_collect
+List C_instrumentation_collect(bool stop);
+RcppExport SEXP _lidR_C_instrumentation_collect(SEXP stopSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< bool >::type stop(stopSEXP);
+    rcpp_result_gen = Rcpp::wrap(C_instrumentation_collect(stop));
     return rcpp_result_gen;
 END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_lidR_C_grid_canopy", (DL_FUNC) &_lidR_C_grid_canopy, 3},
-    {"_lidR_C_knn", (DL_FUNC) &_lidR_C_knn, 5},
-    {"_lidR_C_knnidw", (DL_FUNC) &_lidR_C_knnidw, 7},
-    {"_lidR_C_lassmooth", (DL_FUNC) &_lidR_C_lassmooth, 5},
-    {"_lidR_C_lastrees_li2", (DL_FUNC) &_lidR_C_lastrees_li2, 8},
+    {"_lidR_C_delaunay", (DL_FUNC) &_lidR_C_delaunay, 3},
+    {"_lidR_C_grid_canopy", (DL_FUNC) &_lidR_C_grid_canopy, 4},
+    {"_lidR_C_rasterize", (DL_FUNC) &_lidR_C_rasterize, 6},
+    {"_lidR_C_grid_metrics", (DL_FUNC) &_lidR_C_grid_metrics, 11},
+    {"_lidR_C_voxel_metrics", (DL_FUNC) &_lidR_C_voxel_metrics, 11},
+    {"_lidR_C_voxelize", (DL_FUNC) &_lidR_C_voxelize, 5},
+    {"_lidR_C_knn", (DL_FUNC) &_lidR_C_knn, 7},
+    {"_lidR_C_knnidw", (DL_FUNC) &_lidR_C_knnidw, 9},
+    {"_lidR_C_knnidw_las", (DL_FUNC) &_lidR_C_knnidw_las, 7},
+    {"_lidR_C_lasfilterdecimate", (DL_FUNC) &_lidR_C_lasfilterdecimate, 9},
+    {"_lidR_C_lasfiltersurfacepoints", (DL_FUNC) &_lidR_C_lasfiltersurfacepoints, 5},
+    {"_lidR_C_lasnormalize", (DL_FUNC) &_lidR_C_lasnormalize, 11},
+    {"_lidR_C_lassmooth", (DL_FUNC) &_lidR_C_lassmooth, 10},
+    {"_lidR_C_lastrees_li2", (DL_FUNC) &_lidR_C_lastrees_li2, 10},
     {"_lidR_C_lastrees_dalponte", (DL_FUNC) &_lidR_C_lastrees_dalponte, 6},
-    {"_lidR_C_lastrees_li", (DL_FUNC) &_lidR_C_lastrees_li, 7},
+    {"_lidR_C_lastrees_li", (DL_FUNC) &_lidR_C_lastrees_li, 8},
+    {"_lidR_C_lastrees_silva", (DL_FUNC) &_lidR_C_lastrees_silva, 9},
+    {"_lidR_C_lastrees_watershed", (DL_FUNC) &_lidR_C_lastrees_watershed, 4},
     {"_lidR_C_lasupdateheader", (DL_FUNC) &_lidR_C_lasupdateheader, 2},
-    {"_lidR_C_LocalMaximaMatrix", (DL_FUNC) &_lidR_C_LocalMaximaMatrix, 3},
-    {"_lidR_C_LocalMaximaPoints", (DL_FUNC) &_lidR_C_LocalMaximaPoints, 3},
-    {"_lidR_C_MorphologicalOpening", (DL_FUNC) &_lidR_C_MorphologicalOpening, 5},
+    {"_lidR_C_LocalMaximaMatrix", (DL_FUNC) &_lidR_C_LocalMaximaMatrix, 4},
+    {"_lidR_C_LocalMaximaPoints", (DL_FUNC) &_lidR_C_LocalMaximaPoints, 9},
+    {"_lidR_C_MorphologicalOpening", (DL_FUNC) &_lidR_C_MorphologicalOpening, 7},
+    {"_lidR_C_ProgressiveMorphologicalFilter", (DL_FUNC) &_lidR_C_ProgressiveMorphologicalFilter, 7},
     {"_lidR_C_point_in_polygon", (DL_FUNC) &_lidR_C_point_in_polygon, 4},
     {"_lidR_C_points_in_polygon", (DL_FUNC) &_lidR_C_points_in_polygon, 4},
-    {"_lidR_C_points_in_polygons", (DL_FUNC) &_lidR_C_points_in_polygons, 5},
+    {"_lidR_C_points_in_polygons", (DL_FUNC) &_lidR_C_points_in_polygons, 6},
+    {"_lidR_C_raster_stream_create", (DL_FUNC) &_lidR_C_raster_stream_create, 7},
+    {"_lidR_C_raster_stream_update", (DL_FUNC) &_lidR_C_raster_stream_update, 6},
+    {"_lidR_C_raster_stream_values", (DL_FUNC) &_lidR_C_raster_stream_values, 1},
     {"_lidR_fast_table", (DL_FUNC) &_lidR_fast_table, 2},
     {"_lidR_fast_countequal", (DL_FUNC) &_lidR_fast_countequal, 2},
     {"_lidR_fast_countbelow", (DL_FUNC) &_lidR_fast_countbelow, 2},
     {"_lidR_fast_countover", (DL_FUNC) &_lidR_fast_countover, 2},
+    {"_lidR_fast_summary", (DL_FUNC) &_lidR_fast_summary, 5},
     {"_lidR_fast_extract", (DL_FUNC) &_lidR_fast_extract, 6},
-    {"_lidR_roundc", (DL_FUNC) &_lidR_roundc, 2},
-    {"_lidR_C_tinfo", (DL_FUNC) &_lidR_C_tinfo, 2},
-    {"_lidR_C_tsearch", (DL_FUNC) &_lidR_C_tsearch, 6},
+    {"_lidR_roundc", (DL_FUNC) &_lidR_roundc, 3},
+    {"_lidR_C_index_build", (DL_FUNC) &_lidR_C_index_build, 3},
+    {"_lidR_C_index_valid", (DL_FUNC) &_lidR_C_index_valid, 3},
+    {"_lidR_C_index_write", (DL_FUNC) &_lidR_C_index_write, 3},
+    {"_lidR_C_index_read", (DL_FUNC) &_lidR_C_index_read, 1},
+    {"_lidR_C_tinfo", (DL_FUNC) &_lidR_C_tinfo, 3},
+    {"_lidR_C_tsearch", (DL_FUNC) &_lidR_C_tsearch, 7},
+    {"_lidR_C_tinterpolate", (DL_FUNC) &_lidR_C_tinterpolate, 9},
+    {"_lidR_C_instrumentation_start", (DL_FUNC) &_lidR_C_instrumentation_start, 0},
+    {"_lidR_C_instrumentation_enabled", (DL_FUNC) &_lidR_C_instrumentation_enabled, 0},
+    {"_lidR_C_instrumentation_label", (DL_FUNC) &_lidR_C_instrumentation_label, 1},
+    {"_lidR_C_instrumentation_collect", (DL_FUNC) &_lidR_C_instrumentation_collect, 1},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,121 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef SPATIALINDEX_H
+#define SPATIALINDEX_H
+
+#include <Rcpp.h>
+#include <cstring>
+#include <stdint.h>
+#include "QuadTree.h"
+#include "Instrumentation.h"
+
+// Spatial index of a point cloud shared with R as an external pointer. It holds the QuadTree
+// of the points and a fingerprint of their coordinates so a kernel can check that the index
+// was built on the points it receives. The R side attaches it to the data of a LAS object
+// (see spatial_index()) so a point cloud is indexed once whatever the number of calls.
+struct SpatialIndex
+{
+  SpatialIndex(QuadTree* _tree, int _npoints, uint64_t _fingerprint) : tree(_tree), npoints(_npoints), fingerprint(_fingerprint) {}
+  ~SpatialIndex() { delete tree; }
+
+  QuadTree* tree;
+  int npoints;
+  uint64_t fingerprint;
+};
+
+// FNV-1a hash of the bits of the coordinates
+inline uint64_t coordinates_fingerprint(const Rcpp::NumericVector& X, const Rcpp::NumericVector& Y)
+{
+  uint64_t h = 14695981039346656037ULL;
+  int n = X.length();
+
+  for (int i = 0 ; i < n ; i++)
+  {
+    uint64_t x, y;
+    std::memcpy(&x, &X[i], sizeof(double));
+    std::memcpy(&y, &Y[i], sizeof(double));
+    h = (h ^ x) * 1099511628211ULL;
+    h = (h ^ y) * 1099511628211ULL;
+  }
+
+  return h;
+}
+
+// The index of an external pointer or NULL if it is not an index (or was not restored after
+// a serialization)
+inline SpatialIndex* get_spatial_index(SEXP index)
+{
+  if (Rf_isNull(index) || TYPEOF(index) != EXTPTRSXP)
+    return 0;
+
+  return (SpatialIndex*)R_ExternalPtrAddr(index);
+}
+
+// QuadTree of the points X Y for the duration of a kernel: the tree of 'index' if it is a
+// valid index built on these points, otherwise a temporary tree built on the fly.
+class IndexedPoints
+{
+  public:
+    IndexedPoints(SEXP index, const Rcpp::NumericVector& X, const Rcpp::NumericVector& Y) : owned(false)
+    {
+      SpatialIndex* si = get_spatial_index(index);
+      bool valid = false;
+
+      if (si != 0)
+      {
+        Stage stage("index check");
+        valid = si->npoints == X.length() && si->fingerprint == coordinates_fingerprint(X, Y);
+        stage.add(X.length());
+      }
+
+      if (valid)
+      {
+        tree = si->tree;
+      }
+      else
+      {
+        Stage stage("index build");
+        tree = QuadTreeCreate(X, Y);
+        owned = true;
+        stage.add(X.length());
+      }
+    }
+
+    ~IndexedPoints() { if (owned) delete tree; }
+
+    QuadTree* tree;
+
+  private:
+    bool owned;
+    IndexedPoints(const IndexedPoints&);
+    IndexedPoints& operator=(const IndexedPoints&);
+};
+
+#endif //SPATIALINDEX_H
@@ -0,0 +1,210 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#include "Voxelizer.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+
+Voxelizer::Voxelizer(const double* X, const double* Y, const double* Z, int n, double res, const double* start, const double* core)
+{
+  this->res = res;
+  this->is3d = Z != 0;
+  this->start[0] = start[0];
+  this->start[1] = start[1];
+  this->start[2] = is3d ? start[2] : 0;
+  nvoxels = 0;
+
+  int ndim = is3d ? 3 : 2;
+  const double* coords[3] = {X, Y, Z};
+
+  // Index of each point along each axis: same arithmetic than f_grid()
+  std::vector<double> ijk((size_t)n * ndim);
+  double inf = std::numeric_limits<double>::infinity();
+  double kmin[3] = {inf, inf, inf};
+  double kmax[3] = {-inf, -inf, -inf};
+  std::vector<char> valid(n, 1);
+
+  for (int d = 0 ; d < ndim ; d++)
+  {
+    for (int i = 0 ; i < n ; i++)
+    {
+      double k = round((coords[d][i] - 0.5 * res - start[d]) / res);
+      ijk[(size_t)i * ndim + d] = k;
+
+      if (std::isnan(k))
+      {
+        valid[i] = 0;
+        continue;
+      }
+
+      // Same arithmetic than x() and y()
+      if (core != 0 && d < 2)
+      {
+        double c = k * res + 0.5 * res + start[d];
+
+        if (c < core[d] || c > core[d+2])
+        {
+          valid[i] = 0;
+          continue;
+        }
+      }
+
+      if (k < kmin[d]) kmin[d] = k;
+      if (k > kmax[d]) kmax[d] = k;
+    }
+  }
+
+  // Number of bits needed for each axis
+  int bits[3] = {0, 0, 0};
+  int total = 0;
+
+  for (int d = 0 ; d < ndim ; d++)
+  {
+    double range = kmax[d] - kmin[d];
+    while (range >= std::ldexp(1.0, bits[d])) bits[d]++;
+    total += bits[d];
+  }
+
+  if (total > 64)
+    throw std::runtime_error("The grid is too large: the number of voxels exceeds 2^64.");
+
+  std::vector<uint64_t> keys;
+  std::vector<int> idx;
+  keys.reserve(n);
+  idx.reserve(n);
+
+  for (int i = 0 ; i < n ; i++)
+  {
+    if (!valid[i])
+      continue;
+
+    uint64_t key = 0;
+    int shift = 0;
+
+    for (int d = 0 ; d < ndim ; d++)
+    {
+      key |= ((uint64_t)(ijk[(size_t)i * ndim + d] - kmin[d])) << shift;
+      shift += bits[d];
+    }
+
+    keys.push_back(key);
+    idx.push_back(i);
+  }
+
+  radix_sort(keys, idx, total);
+
+  // Runs of equal keys. The first point of a run is the first point of the voxel because the
+  // sort is stable. The runs are then numbered by order of first appearance.
+  int m = keys.size();
+  std::vector<int> run(n, -1);
+  std::vector<int> runstart;
+
+  for (int k = 0 ; k < m ; k++)
+  {
+    if (k == 0 || keys[k] != keys[k-1])
+    {
+      run[idx[k]] = runstart.size();
+      runstart.push_back(k);
+    }
+  }
+
+  nvoxels = runstart.size();
+  runstart.push_back(m);
+
+  offset.assign(nvoxels + 1, 0);
+  index.resize(m);
+  center.resize((size_t)nvoxels * 3);
+
+  int v = 0;
+
+  for (int i = 0 ; i < n ; i++)
+  {
+    int r = run[i];
+
+    if (r < 0)
+      continue;
+
+    int len = runstart[r+1] - runstart[r];
+    offset[v+1] = offset[v] + len;
+    std::copy(idx.begin() + runstart[r], idx.begin() + runstart[r+1], index.begin() + offset[v]);
+
+    for (int d = 0 ; d < 3 ; d++)
+      center[(size_t)v * 3 + d] = d < ndim ? ijk[(size_t)i * ndim + d] : 0;
+
+    v++;
+  }
+}
+
+Voxelizer::~Voxelizer()
+{
+}
+
+double Voxelizer::x(int v) const { return center[(size_t)v * 3]     * res + 0.5 * res + start[0]; }
+double Voxelizer::y(int v) const { return center[(size_t)v * 3 + 1] * res + 0.5 * res + start[1]; }
+double Voxelizer::z(int v) const { return center[(size_t)v * 3 + 2] * res + 0.5 * res + start[2]; }
+
+// Stable LSD radix sort of the keys (and of their point index) on their 'bits' lower bits
+void Voxelizer::radix_sort(std::vector<uint64_t>& keys, std::vector<int>& idx, int bits)
+{
+  int n = keys.size();
+  const int nbuckets = 1 << RADIX_BITS;
+  const uint64_t mask = nbuckets - 1;
+
+  std::vector<uint64_t> keys2(n);
+  std::vector<int> idx2(n);
+  std::vector<int> count(nbuckets);
+
+  for (int shift = 0 ; shift < bits ; shift += RADIX_BITS)
+  {
+    std::fill(count.begin(), count.end(), 0);
+
+    for (int i = 0 ; i < n ; i++)
+      count[(keys[i] >> shift) & mask]++;
+
+    int sum = 0;
+    for (int b = 0 ; b < nbuckets ; b++)
+    {
+      int c = count[b];
+      count[b] = sum;
+      sum += c;
+    }
+
+    for (int i = 0 ; i < n ; i++)
+    {
+      int pos = count[(keys[i] >> shift) & mask]++;
+      keys2[pos] = keys[i];
+      idx2[pos] = idx[i];
+    }
+
+    keys.swap(keys2);
+    idx.swap(idx2);
+  }
+}
@@ -0,0 +1,72 @@
+/*
+ ===============================================================================
+
+ PROGRAMMERS:
+
+ jean-romain.roussel.1@ulaval.ca  -  https://github.com/Jean-Romain/lidR
+
+ COPYRIGHT:
+
+ Copyright 2016-2018 Jean-Romain Roussel
+
+ This file is part of lidR R package.
+
+ lidR is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This program is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+ ===============================================================================
+ */
+
+#ifndef VOXELIZER_H
+#define VOXELIZER_H
+
+#include <vector>
+#include <stdint.h>
+
+// Partition of a point cloud into the cells of a regular 2D grid or into the voxels of a
+// regular 3D grid, with the same arithmetic than f_grid() on the R side.
+//
+// The (i, j, k) indices of each point are packed into a single 64 bits key using only the
+// number of bits needed by the extent of the point cloud. The keys are sorted with a stable
+// LSD radix sort so the points of a voxel are contiguous and in their original order. The
+// voxels are numbered by order of first appearance like a data.table grouping. Points with a
+// NA coordinate do not belong to any voxel.
+//
+// If core = {xmin, ymin, xmax, ymax} is given, only the points of the voxels whose center lies
+// in this rectangle are binned. The others are ignored like the NAs. This is how the buffer of a
+// cluster of a catalog is not computed.
+class Voxelizer
+{
+  public:
+    Voxelizer(const double* X, const double* Y, const double* Z, int n, double res, const double* start, const double* core = 0);
+    ~Voxelizer();
+    double x(int v) const;                        // Coordinates of the center of voxel v
+    double y(int v) const;
+    double z(int v) const;
+
+    int nvoxels;
+    std::vector<int> offset;                      // Points of voxel v are index[offset[v]] to index[offset[v+1]-1]
+    std::vector<int> index;
+
+  private:
+    static const int RADIX_BITS = 11;
+
+    bool is3d;
+    double res;
+    double start[3];
+    std::vector<double> center;                   // (i, j, k) of each voxel
+
+    void radix_sort(std::vector<uint64_t>& keys, std::vector<int>& idx, int bits);
+};
+
+#endif //VOXELIZER_H
@@ -0,0 +1,17 @@
+#ifndef MYOMP_H
+#define MYOMP_H
+
+// OpenMP is optional. If the compiler does not support it the pragmas are ignored and these
+// stubs make the kernels run serially.
+
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include <chrono>
+inline int omp_get_thread_num() { return 0; }
+inline int omp_get_num_threads() { return 1; }
+inline int omp_get_max_threads() { return 1; }
+inline double omp_get_wtime() { return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+#endif
+
+#endif //MYOMP_H